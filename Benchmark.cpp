@@ -0,0 +1,383 @@
+#include <Urho3D/Audio/Audio.h>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <Urho3D/Graphics/Drawable.h>
+#include <Urho3D/Graphics/Octree.h>
+
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Physics/PhysicsWorld.h>
+
+#include <Urho3D/Scene/Scene.h>
+
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "Benchmark.h"
+#include "GameConfig.h"
+#include "JobSystem.h"
+#include "Leaderboard.h"
+#include "Obstacle.h"
+#include "ObstacleSystem.h"
+#include "PipeGenerator.h"
+#include "RenderQuality.h"
+#include "SoundSystem.h"
+#include "Telemetry.h"
+
+Benchmark::Benchmark(Context* context): Object(context) {
+}
+
+void Benchmark::Run(Scene* scene) {
+    RunScaling(scene);
+    RunRestart();
+    RunBroadphase(scene);
+    RunFlattening(scene);
+    RunRenderScale();
+    RunTelemetry();
+    RunAudio();
+    RunLeaderboard();
+}
+
+void Benchmark::RunScaling(Scene* scene) {
+    auto* jobs = GetSubsystem<JobSystem>();
+    auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+    auto* obstacleSystem = GetSubsystem<ObstacleSystem>();
+
+    unsigned maxThreads = jobs->GetMaxThreadCount();
+    URHO3D_LOGINFOF("Scaling: %u descents of %u steps, up to %u threads", BENCHMARK_DESCENTS, BENCHMARK_STEPS_PER_DESCENT, maxThreads);
+    URHO3D_LOGINFO("Scaling: threads  generate ms  obstacles ms  speedup");
+
+    long long baselineTime = 0;
+    Vector3 baselineChecksum;
+    for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+        jobs->SetThreadCount(threads);
+        SetRandomSeed(BENCHMARK_SEED);
+        pipeGenerator->Reset();
+
+        HiresTimer timer;
+        long long generateTime = 0;
+        long long obstacleTime = 0;
+        for (unsigned i = 0; i < BENCHMARK_DESCENTS; ++i) {
+            timer.Reset();
+            pipeGenerator->GeneratePipes();
+            generateTime += timer.GetUSec(false);
+
+            timer.Reset();
+            for (unsigned j = 0; j < BENCHMARK_STEPS_PER_DESCENT; ++j) {
+                obstacleSystem->Update(BENCHMARK_TIME_STEP);
+            }
+            obstacleTime += timer.GetUSec(false);
+        }
+
+        long long totalTime = generateTime + obstacleTime;
+        Vector3 checksum = ObstacleChecksum(scene);
+        if (threads == 1) {
+            baselineTime = totalTime;
+            baselineChecksum = checksum;
+        } else if (checksum != baselineChecksum) {
+            URHO3D_LOGERRORF("Scaling: %u threads diverged from the single-threaded run", threads);
+        }
+
+        URHO3D_LOGINFOF("Scaling: %7u  %11.3f  %12.3f  %7.2f", threads, generateTime / 1000.0f, obstacleTime / 1000.0f,
+            totalTime ? (float)baselineTime / totalTime : 1.0f);
+    }
+
+    jobs->SetThreadCount(0);
+    pipeGenerator->Reset();
+}
+
+void Benchmark::RunRestart() {
+    auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+
+    HiresTimer timer;
+    long long prepareTime = 0;
+    long long restartTime = 0;
+    for (unsigned i = 0; i < BENCHMARK_RESTARTS; ++i) {
+        // Spare pipes are normally prepared in idle frames, outside of the restart itself
+        timer.Reset();
+        while (!pipeGenerator->PrepareSpare()) {
+        }
+        prepareTime += timer.GetUSec(false);
+
+        timer.Reset();
+        pipeGenerator->Reset();
+        restartTime += timer.GetUSec(false);
+    }
+
+    URHO3D_LOGINFOF("Restart: %.3f ms per restart, %.3f ms spare preparation in idle frames",
+        restartTime / 1000.0f / BENCHMARK_RESTARTS, prepareTime / 1000.0f / BENCHMARK_RESTARTS);
+}
+
+void Benchmark::RunBroadphase(Scene* scene) {
+    auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+    auto* world = scene->GetComponent<PhysicsWorld>();
+
+    // The same seed draws the same candidates, unchecked placement keeps the first ones like the old random placement
+    for (unsigned checked = 0; checked < 2; ++checked) {
+        pipeGenerator->SetPlacementChecks(checked != 0);
+        SetRandomSeed(BENCHMARK_SEED);
+        pipeGenerator->Reset();
+
+        HiresTimer timer;
+        long long stepTime = 0;
+        unsigned long long pairs = 0;
+        for (unsigned i = 0; i < BENCHMARK_BROADPHASE_DESCENTS; ++i) {
+            pipeGenerator->GeneratePipes();
+
+            for (unsigned j = 0; j < BENCHMARK_STEPS_PER_DESCENT; ++j) {
+                timer.Reset();
+                world->Update(BENCHMARK_TIME_STEP);
+                stepTime += timer.GetUSec(false);
+                pairs += world->GetWorld()->getPairCache()->getNumOverlappingPairs();
+            }
+        }
+
+        unsigned steps = BENCHMARK_BROADPHASE_DESCENTS * BENCHMARK_STEPS_PER_DESCENT;
+        const PlacementStats& placement = pipeGenerator->GetPlacementStats();
+        URHO3D_LOGINFOF("Broadphase: %s placement, %.1f pairs and %.3f ms per step, %u obstacles, %u overlapping, %u "
+            "path blocking and %u seam rejected, %u missing", checked ? "checked" : "unchecked", (float)pairs / steps,
+            stepTime / 1000.0f / steps, placement.placed_, placement.overlaps_, placement.blocked_, placement.seams_,
+            placement.missing_);
+    }
+
+    pipeGenerator->Reset();
+}
+
+void Benchmark::RunFlattening(Scene* scene) {
+    auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+    auto* obstacleSystem = GetSubsystem<ObstacleSystem>();
+    auto* octree = scene->GetComponent<Octree>();
+
+    // Headless runs have no renderer driving the octree, so it is updated here after each obstacle step like a frame would
+    FrameInfo frame;
+    frame.frameNumber_ = 0;
+    frame.timeStep_ = BENCHMARK_TIME_STEP;
+    frame.camera_ = nullptr;
+    for (unsigned baked = 0; baked < 2; ++baked) {
+        pipeGenerator->SetBakeChunks(baked != 0);
+        SetRandomSeed(BENCHMARK_SEED);
+        pipeGenerator->Reset();
+        octree->Update(frame);
+
+        HiresTimer timer;
+        long long obstacleTime = 0;
+        long long octreeTime = 0;
+        for (unsigned i = 0; i < BENCHMARK_FLATTENING_DESCENTS; ++i) {
+            pipeGenerator->GeneratePipes();
+            octree->Update(frame);
+
+            for (unsigned j = 0; j < BENCHMARK_STEPS_PER_DESCENT; ++j) {
+                ++frame.frameNumber_;
+
+                timer.Reset();
+                obstacleSystem->Update(BENCHMARK_TIME_STEP);
+                obstacleTime += timer.GetUSec(false);
+
+                timer.Reset();
+                octree->Update(frame);
+                octreeTime += timer.GetUSec(false);
+            }
+        }
+
+        PODVector<Drawable*> drawables;
+        scene->GetDerivedComponents<Drawable>(drawables, true);
+
+        unsigned steps = BENCHMARK_FLATTENING_DESCENTS * BENCHMARK_STEPS_PER_DESCENT;
+        URHO3D_LOGINFOF("Flattening: %s pipes, %u nodes, %u drawables, %.3f ms obstacle step and %.3f ms octree update per frame",
+            baked ? "baked" : "hierarchical", scene->GetNumChildren(true), drawables.Size(), obstacleTime / 1000.0f / steps,
+            octreeTime / 1000.0f / steps);
+    }
+
+    pipeGenerator->Reset();
+}
+
+void Benchmark::RunRenderScale() {
+    // Synthetic machines: CPU and GPU milliseconds per frame at the high tier and full render scale
+    struct Machine {
+        const char* name_;
+        float cpuTime_;
+        float gpuTime_;
+    };
+    static const Machine machines[] = {
+        { "discrete", 4.0f, 6.0f },
+        { "integrated", 6.0f, 30.0f },
+        { "software", 30.0f, 40.0f }
+    };
+    static const float tierCost[] = { 0.5f, 0.75f, 1.0f };
+
+    float target = 1000.0f / Config().targetFps_;
+    RenderScaleController controller;
+    for (const auto& machine : machines) {
+        controller.Reset(target, TIER_HIGH);
+
+        float frameTime = target;
+        for (unsigned i = 0; i < BENCHMARK_RENDER_FRAMES; ++i) {
+            // GPU time follows the pixel count, CPU and GPU overlap and frames are paced to the target
+            float scale = controller.GetRenderScale();
+            float cost = tierCost[controller.GetTier()];
+            float workTime = machine.cpuTime_ * cost;
+            frameTime = Max(target, Max(workTime, machine.gpuTime_ * cost * scale * scale));
+
+            if (controller.Update(frameTime, workTime)) {
+                URHO3D_LOGINFOF("Render scale: %s frame %u -> tier %s, scale %.1f", machine.name_, i,
+                    RenderQuality::GetTierSettings(controller.GetTier()).name_, controller.GetRenderScale());
+            }
+        }
+
+        URHO3D_LOGINFOF("Render scale: %s settled at tier %s, scale %.1f, %.2f ms per frame (target %.2f ms)", machine.name_,
+            RenderQuality::GetTierSettings(controller.GetTier()).name_, controller.GetRenderScale(), frameTime, target);
+    }
+}
+
+void Benchmark::RunTelemetry() {
+    auto* telemetry = GetSubsystem<Telemetry>();
+    if (!telemetry->Start("null")) {
+        return;
+    }
+
+    // Push in half-ring batches and let the writer drain in between, a full ring would only measure the drop path
+    unsigned batchSize = TELEMETRY_RING_SIZE / 2;
+    HiresTimer timer;
+    long long recordTime = 0;
+    for (unsigned i = 0; i < BENCHMARK_TELEMETRY_RECORDS; i += batchSize) {
+        timer.Reset();
+        for (unsigned j = 0; j < batchSize; ++j) {
+            telemetry->Record(TELEMETRY_SCORE, (float)(i + j));
+        }
+        recordTime += timer.GetUSec(false);
+
+        Time::Sleep(TELEMETRY_DRAIN_INTERVAL * 2);
+    }
+
+    unsigned dropped = telemetry->GetDroppedCount();
+    telemetry->Stop();
+
+    float recordCost = recordTime * 1000.0f / BENCHMARK_TELEMETRY_RECORDS;
+    float frameBudget = 1000000000.0f / Config().targetFps_;
+    URHO3D_LOGINFOF("Telemetry: %.1f ns per record, %u dropped, %.4f%% of a %.0f FPS frame at %u records per frame", recordCost,
+        dropped, recordCost * BENCHMARK_TELEMETRY_RECORDS_PER_FRAME / frameBudget * 100.0f, Config().targetFps_,
+        BENCHMARK_TELEMETRY_RECORDS_PER_FRAME);
+}
+
+void Benchmark::RunAudio() {
+    auto* audio = GetSubsystem<Audio>();
+    auto* soundSystem = GetSubsystem<SoundSystem>();
+    Node* listener = soundSystem->GetListener();
+    if (!audio->IsInitialized() || !listener) {
+        URHO3D_LOGWARNING("Audio: not initialized, benchmark skipped");
+        return;
+    }
+
+    // Fall down the opening pipes with the engine running, a stinger every few frames and a crash now and then,
+    // while drips spawn around the listener. Frames are paced so the audio thread mixes as in gameplay
+    soundSystem->ResetStats();
+    soundSystem->StartEngine();
+    listener->SetPosition(Vector3::ZERO);
+    for (unsigned i = 0; i < BENCHMARK_AUDIO_FRAMES; ++i) {
+        Vector3 position = listener->GetPosition() + Vector3::DOWN * BENCHMARK_AUDIO_SPEED * BENCHMARK_TIME_STEP;
+        listener->SetPosition(position);
+        soundSystem->SetEngineSpeed(BENCHMARK_AUDIO_SPEED);
+
+        if (i % 10 == 0) {
+            soundSystem->PlayNearMiss(position + Vector3(5.0f, -20.0f, 0.0f));
+        }
+        if (i % 100 == 99) {
+            soundSystem->PlayCrash(position);
+        }
+
+        soundSystem->Update(BENCHMARK_TIME_STEP);
+        audio->Update(BENCHMARK_TIME_STEP);
+        Time::Sleep((unsigned)(BENCHMARK_TIME_STEP * 1000.0f));
+    }
+    soundSystem->StopEngine();
+
+    const SoundStats& stats = soundSystem->GetStats();
+    URHO3D_LOGINFOF("Audio: mixer %.2f%% of a core, %.1f us per fragment, %u voices, %u sounds played, %u stolen, %u culled, %u dropped",
+        soundSystem->GetMixerLoad() * 100.0f, soundSystem->GetMixTime(), AUDIO_VOICES, stats.played_, stats.stolen_, stats.culled_,
+        stats.dropped_);
+}
+
+void Benchmark::RunLeaderboard() {
+    auto* fileSystem = GetSubsystem<FileSystem>();
+    String fileName = fileSystem->GetAppPreferencesDir("PipeProbe", "PipeProbe") + "LeaderboardBenchmark.log";
+    fileSystem->Delete(fileName);
+
+    SharedPtr<Leaderboard> leaderboard(new Leaderboard(context_));
+    if (!leaderboard->Open(fileName)) {
+        return;
+    }
+
+    SetRandomSeed(BENCHMARK_SEED);
+    HiresTimer timer;
+    for (unsigned i = 0; i < BENCHMARK_LEADERBOARD_DURABLE_APPENDS; ++i) {
+        leaderboard->Append(Rand() * 4, i, 60.0f, i % 10);
+    }
+    long long durableTime = timer.GetUSec(true);
+
+    // Flushing every record would measure the disk, millions of records are filled with durability off
+    leaderboard->SetDurable(false);
+    for (unsigned i = leaderboard->GetRecordCount(); i < BENCHMARK_LEADERBOARD_RECORDS; ++i) {
+        leaderboard->Append(Rand() * 4 + Rand() % 4, i, 60.0f, i % 10);
+    }
+    long long fillTime = timer.GetUSec(true);
+    leaderboard->SetDurable(true);
+
+    leaderboard->Close();
+    timer.Reset();
+    leaderboard->Open(fileName);
+    long long openTime = timer.GetUSec(true);
+
+    std::vector<LeaderboardRecord> top;
+    for (unsigned i = 0; i < BENCHMARK_LEADERBOARD_LOOKUPS; ++i) {
+        top.clear();
+        leaderboard->GetTop(top);
+    }
+    long long lookupTime = timer.GetUSec(true);
+
+    // A full scan for comparison, which also checks the incrementally maintained index
+    std::vector<unsigned> scores;
+    for (unsigned i = 0; i < leaderboard->GetRecordCount(); ++i) {
+        const LeaderboardRecord& record = leaderboard->GetRecord(i);
+        if (scores.size() < LEADERBOARD_SIZE || record.score_ > scores.back()) {
+            scores.insert(std::upper_bound(scores.begin(), scores.end(), record.score_, std::greater<unsigned>()), record.score_);
+            if (scores.size() > LEADERBOARD_SIZE) {
+                scores.pop_back();
+            }
+        }
+    }
+    long long scanTime = timer.GetUSec(false);
+
+    for (unsigned i = 0; i < scores.size(); ++i) {
+        if (i >= top.size() || top[i].score_ != scores[i]) {
+            URHO3D_LOGERROR("Leaderboard: index differs from a full scan");
+            break;
+        }
+    }
+
+    URHO3D_LOGINFOF("Leaderboard: %u records, %.3f ms per durable append, %.3f us per buffered append, %.3f ms open",
+        leaderboard->GetRecordCount(), durableTime / 1000.0f / BENCHMARK_LEADERBOARD_DURABLE_APPENDS,
+        (float)fillTime / (leaderboard->GetRecordCount() - BENCHMARK_LEADERBOARD_DURABLE_APPENDS), openTime / 1000.0f);
+    URHO3D_LOGINFOF("Leaderboard: top %u in %.3f us from the index, %.3f ms by full scan", LEADERBOARD_SIZE,
+        (float)lookupTime / BENCHMARK_LEADERBOARD_LOOKUPS, scanTime / 1000.0f);
+
+    leaderboard->Close();
+    fileSystem->Delete(fileName);
+}
+
+Vector3 Benchmark::ObstacleChecksum(Scene* scene) {
+    PODVector<Obstacle*> obstacles;
+    scene->GetComponents<Obstacle>(obstacles, true);
+
+    Vector3 checksum;
+    for (auto* obstacle : obstacles) {
+        checksum += obstacle->GetNode()->GetWorldPosition();
+    }
+
+    return checksum;
+}
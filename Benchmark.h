@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D {
+    class Scene;
+}
+
+using namespace Urho3D;
+
+const unsigned BENCHMARK_SEED = 1;
+const unsigned BENCHMARK_DESCENTS = 200;
+const unsigned BENCHMARK_STEPS_PER_DESCENT = 60;
+const float BENCHMARK_TIME_STEP = 1.0f / 60.0f;
+const unsigned BENCHMARK_RESTARTS = 100;
+const unsigned BENCHMARK_BROADPHASE_DESCENTS = 50;
+const unsigned BENCHMARK_FLATTENING_DESCENTS = 50;
+/// Frames of real time, the null sink consumes audio at the device rate.
+const unsigned BENCHMARK_AUDIO_FRAMES = 300;
+const float BENCHMARK_AUDIO_SPEED = 150.0f;
+const unsigned BENCHMARK_LEADERBOARD_RECORDS = 4000000;
+const unsigned BENCHMARK_LEADERBOARD_DURABLE_APPENDS = 100;
+const unsigned BENCHMARK_LEADERBOARD_LOOKUPS = 100000;
+const unsigned BENCHMARK_RENDER_FRAMES = 3000;
+const unsigned BENCHMARK_TELEMETRY_RECORDS = 262144;
+/// Records per frame in gameplay: score, frame time and an occasional near miss or new segments.
+const unsigned BENCHMARK_TELEMETRY_RECORDS_PER_FRAME = 4;
+
+/// Headless benchmark of game-side systems. Started with the -benchmark command line option.
+class Benchmark: public Object {
+
+    URHO3D_OBJECT(Benchmark, Object)
+
+public:
+    explicit Benchmark(Context* context);
+
+    /// Run all benchmarks on the scene and log the results.
+    void Run(Scene* scene);
+
+private:
+    void RunScaling(Scene* scene);
+    void RunRestart();
+    void RunBroadphase(Scene* scene);
+    void RunFlattening(Scene* scene);
+    void RunRenderScale();
+    void RunTelemetry();
+    void RunAudio();
+    void RunLeaderboard();
+    Vector3 ObstacleChecksum(Scene* scene);
+};
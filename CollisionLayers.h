@@ -1,5 +0,0 @@
-#pragma once
-
-static const unsigned LAYER_WORLD = 2;
-static const unsigned LAYER_OBSTACLE = 4;
-static const unsigned LAYER_PIPE = 8;
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+
+#include <Urho3D/IO/Log.h>
+
+#include "DifficultyController.h"
+#include "GameConfig.h"
+#include "Hud.h"
+#include "PerformanceMonitor.h"
+
+DifficultyController::DifficultyController(Context* context):
+    Object(context),
+    densityLimit_(M_MAX_UNSIGNED),
+    active_(false) {
+
+    Reset();
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(DifficultyController, HandleUpdate));
+}
+
+void DifficultyController::RegisterObject(Context* context) {
+    context->RegisterSubsystem<DifficultyController>();
+}
+
+void DifficultyController::Reset() {
+    score_ = 0;
+    densityLimit_ = Min(densityLimit_, Config().maxObstacles_);
+    linearDamping_ = Config().baseDamping_;
+    obstacleCount_ = Min(Config().baseObstacles_, densityLimit_);
+    obstacleReach_ = Min(Config().baseReach_, GetReachLimit());
+    adjustTimer_.Reset();
+}
+
+void DifficultyController::ResetDensityLimit() {
+    densityLimit_ = Config().maxObstacles_;
+    Reset();
+}
+
+void DifficultyController::SetActive(bool active) {
+    if (active && !active_) {
+        adjustTimer_.Reset();
+    }
+    active_ = active;
+}
+
+float DifficultyController::GetLinearDamping() const {
+    return linearDamping_;
+}
+
+unsigned DifficultyController::GetObstacleCount() const {
+    return obstacleCount_;
+}
+
+float DifficultyController::GetObstacleReach() const {
+    return obstacleReach_;
+}
+
+void DifficultyController::HandleUpdate(StringHash eventType, VariantMap& eventData) {
+    if (!active_) {
+        return;
+    }
+
+    int score = GetSubsystem<Hud>()->GetPoints();
+    if (adjustTimer_.GetMSec(false) > Config().adjustInterval_) {
+        adjustTimer_.Reset();
+        UpdateDensityLimit();
+    }
+
+    if (score == score_) {
+        return;
+    }
+
+    score_ = score;
+    const GameConfig& config = Config();
+    linearDamping_ = Max(config.baseDamping_ - score * config.dampingPerPoint_, config.minDamping_);
+    obstacleReach_ = Min(Min(config.baseReach_ + score * config.reachPerPoint_, config.maxReach_), GetReachLimit());
+
+    unsigned obstacleCount = Min(config.baseObstacles_ + (unsigned)Max(score, 0) / config.pointsPerObstacle_, config.maxObstacles_);
+    obstacleCount = Min(obstacleCount, densityLimit_);
+    if (obstacleCount != obstacleCount_) {
+        obstacleCount_ = obstacleCount;
+        Log("score");
+    }
+}
+
+void DifficultyController::UpdateDensityLimit() {
+    // Work time excludes vsync waits, so a capped frame rate does not look like an overloaded machine
+    auto* monitor = GetSubsystem<PerformanceMonitor>();
+    const GameConfig& config = Config();
+    float budget = 1000.0f / config.targetFps_;
+    float workTime = monitor->GetWorkTime();
+
+    if (workTime > budget * config.budgetHigh_ && densityLimit_ > 1) {
+        densityLimit_ = Min(densityLimit_, obstacleCount_) - 1;
+        obstacleCount_ = Min(obstacleCount_, densityLimit_);
+        Log("over budget");
+    } else if (workTime < budget * config.budgetLow_ && densityLimit_ < config.maxObstacles_) {
+        ++densityLimit_;
+        Log("under budget");
+    }
+}
+
+float DifficultyController::GetReachLimit() const {
+    // Obstacles start at the minimum offset from the wall, beyond the pipe axis they would fill the opposite side
+    return Max(Config().pipeRadius_ - Config().obstacleMinOffset_, 0.0f);
+}
+
+void DifficultyController::Log(const char* reason) {
+    auto* monitor = GetSubsystem<PerformanceMonitor>();
+    URHO3D_LOGINFOF("Difficulty (%s): score %d, damping %.4f, obstacles %u (limit %u), reach %.2f; "
+        "frame %.2f ms, work %.2f ms, physics %.2f ms (step %.2f ms)",
+        reason, score_, linearDamping_, obstacleCount_, densityLimit_, obstacleReach_,
+        monitor->GetFrameTime(), monitor->GetWorkTime(), monitor->GetPhysicsTime(), monitor->GetPhysicsStepTime());
+}
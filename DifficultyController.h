@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+using namespace Urho3D;
+
+/// Scales probe speed, obstacle density and gaps from the score, limiting density by measured frame cost.
+class DifficultyController: public Object {
+
+    URHO3D_OBJECT(DifficultyController, Object)
+
+public:
+    explicit DifficultyController(Context* context);
+    static void RegisterObject(Context* context);
+
+    /// Return to zero-score difficulty. Keeps the density limit learned on this machine.
+    void Reset();
+    /// Forget the learned density limit and return to zero-score difficulty. Called after the configuration is loaded.
+    void ResetDensityLimit();
+    /// Adapt to the score and frame cost only while a run is active, menu and crash screens say nothing about gameplay load.
+    void SetActive(bool active);
+
+    float GetLinearDamping() const;
+    unsigned GetObstacleCount() const;
+    float GetObstacleReach() const;
+
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+
+private:
+    void UpdateDensityLimit();
+    float GetReachLimit() const;
+    void Log(const char* reason);
+
+    float linearDamping_;
+    unsigned obstacleCount_;
+    float obstacleReach_;
+    unsigned densityLimit_;
+    int score_;
+    bool active_;
+    Timer adjustTimer_;
+};
@@ -0,0 +1,142 @@
+#include <Urho3D/Core/Context.h>
+
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#include "GameConfig.h"
+
+#ifdef PIPEPROBE_TUNABLE_CONFIG
+GameConfig gameConfig;
+
+struct FloatParameter {
+    const char* name_;
+    float GameConfig::* member_;
+};
+
+struct UIntParameter {
+    const char* name_;
+    unsigned GameConfig::* member_;
+};
+
+static const FloatParameter floatParameters[] = {
+    { "PipeRadius", &GameConfig::pipeRadius_ },
+    { "PipeScale", &GameConfig::pipeScale_ },
+    { "GenerationDistance", &GameConfig::generationDistance_ },
+    { "PipeLightRange", &GameConfig::pipeLightRange_ },
+    { "ObstacleMinOffset", &GameConfig::obstacleMinOffset_ },
+    { "ObstacleScale", &GameConfig::obstacleScale_ },
+    { "CameraDistance", &GameConfig::cameraDistance_ },
+    { "CameraWallOffset", &GameConfig::cameraWallOffset_ },
+    { "CameraPivotSmoothTime", &GameConfig::cameraPivotSmoothTime_ },
+    { "CameraDistanceSmoothTime", &GameConfig::cameraDistanceSmoothTime_ },
+    { "SteeringFactor", &GameConfig::steeringFactor_ },
+    { "CcdRadiusFactor", &GameConfig::ccdRadiusFactor_ },
+    { "TargetFps", &GameConfig::targetFps_ },
+    { "BaseDamping", &GameConfig::baseDamping_ },
+    { "DampingPerPoint", &GameConfig::dampingPerPoint_ },
+    { "MinDamping", &GameConfig::minDamping_ },
+    { "BaseReach", &GameConfig::baseReach_ },
+    { "MaxReach", &GameConfig::maxReach_ },
+    { "ReachPerPoint", &GameConfig::reachPerPoint_ },
+    { "BudgetHigh", &GameConfig::budgetHigh_ },
+    { "BudgetLow", &GameConfig::budgetLow_ }
+};
+
+static const UIntParameter uintParameters[] = {
+    { "PipesPerGeneration", &GameConfig::pipesPerGeneration_ },
+    { "PipesKeptMax", &GameConfig::pipesKeptMax_ },
+    { "PipesKept", &GameConfig::pipesKept_ },
+    { "LightsPerPipe", &GameConfig::lightsPerPipe_ },
+    { "ObstacleCandidates", &GameConfig::obstacleCandidates_ },
+    { "BaseObstacles", &GameConfig::baseObstacles_ },
+    { "MaxObstacles", &GameConfig::maxObstacles_ },
+    { "PointsPerObstacle", &GameConfig::pointsPerObstacle_ },
+    { "AdjustInterval", &GameConfig::adjustInterval_ },
+    { "LayerWorld", &GameConfig::layerWorld_ },
+    { "LayerObstacle", &GameConfig::layerObstacle_ },
+    { "LayerPipe", &GameConfig::layerPipe_ }
+};
+
+static bool SetParameter(const String& name, const String& value) {
+    for (const auto& parameter : floatParameters) {
+        if (name.Compare(parameter.name_, false) == 0) {
+            gameConfig.*parameter.member_ = ToFloat(value);
+            return true;
+        }
+    }
+
+    for (const auto& parameter : uintParameters) {
+        if (name.Compare(parameter.name_, false) == 0) {
+            gameConfig.*parameter.member_ = ToUInt(value);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void ValidatePositive(const char* name, float& value, float fallback) {
+    if (!(value > 0.0f)) {
+        URHO3D_LOGWARNINGF("Config: %s = %g rejected, must be positive, using %g", name, value, fallback);
+        value = fallback;
+    }
+}
+
+static void ValidateMinimum(const char* name, unsigned& value, unsigned minimum) {
+    if (value < minimum) {
+        URHO3D_LOGWARNINGF("Config: %s = %u rejected, must be at least %u", name, value, minimum);
+        value = minimum;
+    }
+}
+
+static void Validate() {
+    // Values the code divides by or loops over, a bad file must not hang or crash the game
+    const GameConfig defaults;
+    ValidatePositive("PipeScale", gameConfig.pipeScale_, defaults.pipeScale_);
+    ValidatePositive("TargetFps", gameConfig.targetFps_, defaults.targetFps_);
+    ValidateMinimum("LightsPerPipe", gameConfig.lightsPerPipe_, 1);
+    ValidateMinimum("PointsPerObstacle", gameConfig.pointsPerObstacle_, 1);
+
+    if (gameConfig.pipesKept_ > gameConfig.pipesKeptMax_) {
+        URHO3D_LOGWARNINGF("Config: PipesKept = %u rejected, must not exceed PipesKeptMax = %u", gameConfig.pipesKept_,
+            gameConfig.pipesKeptMax_);
+        gameConfig.pipesKept_ = gameConfig.pipesKeptMax_;
+    }
+}
+
+bool GameConfig::Load(Context* context, const String& fileName) {
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    if (!cache->Exists(fileName)) {
+        return false;
+    }
+
+    auto* file = cache->GetResource<XMLFile>(fileName);
+    if (!file) {
+        return false;
+    }
+
+    for (XMLElement parameter = file->GetRoot().GetChild("parameter"); parameter; parameter = parameter.GetNext("parameter")) {
+        String name = parameter.GetAttribute("name");
+        String value = parameter.GetAttribute("value");
+        if (SetParameter(name, value)) {
+            URHO3D_LOGINFOF("Config: %s = %s", name.CString(), value.CString());
+        } else {
+            URHO3D_LOGWARNINGF("Config: unknown parameter %s in %s", name.CString(), fileName.CString());
+        }
+    }
+
+    Validate();
+
+    return true;
+}
+#else
+bool GameConfig::Load(Context* context, const String& fileName) {
+    if (context->GetSubsystem<ResourceCache>()->Exists(fileName)) {
+        URHO3D_LOGWARNINGF("Config: %s ignored, gameplay constants are compiled in", fileName.CString());
+    }
+
+    return false;
+}
+#endif
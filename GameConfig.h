@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+
+namespace Urho3D {
+    class Context;
+}
+
+using namespace Urho3D;
+
+/// Gameplay tunables with compile-time defaults.
+/// Builds with PIPEPROBE_TUNABLE_CONFIG read overrides from XML at startup, other builds fold the defaults into the code.
+struct GameConfig {
+    // Pipes, in model units scaled by pipeScale_
+    float pipeRadius_ = 10.0f;
+    float pipeScale_ = 5.0f;
+    unsigned pipesPerGeneration_ = 3;
+    /// Old pipes are pruned down to pipesKept_ once more than pipesKeptMax_ exist.
+    unsigned pipesKeptMax_ = 10;
+    unsigned pipesKept_ = 5;
+    /// New pipes are generated when the probe gets closer than this to the last pipe end.
+    float generationDistance_ = 500.0f;
+    unsigned lightsPerPipe_ = 4;
+    float pipeLightRange_ = 150.0f;
+    float obstacleMinOffset_ = 2.5f;
+    /// Obstacle scale relative to the pipe node.
+    float obstacleScale_ = 0.4f;
+    /// Random placements tried per obstacle before a segment settles for fewer obstacles.
+    unsigned obstacleCandidates_ = 4;
+
+    // Camera
+    float cameraDistance_ = 45.0f;
+    float cameraWallOffset_ = 0.5f;
+    float cameraPivotSmoothTime_ = 0.05f;
+    float cameraDistanceSmoothTime_ = 0.3f;
+
+    // Probe
+    float steeringFactor_ = 3.0f;
+    /// Share of the probe's smallest half extent used as CCD swept sphere radius and motion threshold.
+    float ccdRadiusFactor_ = 0.8f;
+
+    // Difficulty
+    float targetFps_ = 60.0f;
+    /// Probe linear damping at zero score and its decrease per point. Less damping means higher terminal speed.
+    float baseDamping_ = 0.2f;
+    float dampingPerPoint_ = 0.0002f;
+    float minDamping_ = 0.05f;
+    /// Obstacles per pipe segment at zero score and points needed for one more.
+    unsigned baseObstacles_ = 5;
+    unsigned maxObstacles_ = 12;
+    unsigned pointsPerObstacle_ = 500;
+    /// Maximum obstacle offset beyond the minimum offset, growing with score. Larger reach leaves smaller gaps. Limited so
+    /// obstacles never pass the pipe axis.
+    float baseReach_ = 5.0f;
+    float maxReach_ = 7.5f;
+    float reachPerPoint_ = 0.0005f;
+    /// Work time share of the frame budget above which density is limited and below which it may recover.
+    float budgetHigh_ = 0.9f;
+    float budgetLow_ = 0.6f;
+    unsigned adjustInterval_ = 2000;
+
+    // Collision layers
+    unsigned layerWorld_ = 2;
+    unsigned layerObstacle_ = 4;
+    unsigned layerPipe_ = 8;
+
+    /// Override values from an XML file of <parameter name="" value="" /> elements. Return false when not tunable or not loaded.
+    static bool Load(Context* context, const String& fileName);
+};
+
+#ifdef PIPEPROBE_TUNABLE_CONFIG
+extern GameConfig gameConfig;
+
+inline const GameConfig& Config() {
+    return gameConfig;
+}
+#else
+constexpr GameConfig gameConfig{};
+
+constexpr const GameConfig& Config() {
+    return gameConfig;
+}
+#endif
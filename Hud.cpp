@@ -14,8 +14,9 @@
 #include <Urho3D/UI/UIEvents.h>
 
 #include "Hud.h"
+#include "Telemetry.h"
 
-Hud::Hud(Context* context): Object(context), points_(0) {
+Hud::Hud(Context* context): Object(context), points_(0), nearMisses_(0) {
     auto* ui = GetSubsystem<UI>();
     UIElement* uiRoot = ui->GetRoot();
 
@@ -52,12 +53,17 @@ void Hud::Reset(const String& informationText) {
     information_->SetVisible(true);
     pointsValue_->SetVisible(false);
     points_ = 0;
+    nearMisses_ = 0;
 }
 
 int Hud::GetPoints() {
     return points_;
 }
 
+unsigned Hud::GetNearMisses() const {
+    return nearMisses_;
+}
+
 void Hud::AddPoints(int points) {
     if (!pointsValue_->IsVisible()) {
         information_->SetVisible(false);
@@ -65,6 +71,7 @@ void Hud::AddPoints(int points) {
     }
 
     points_ += points;
+    GetSubsystem<Telemetry>()->Record(TELEMETRY_SCORE, points_);
 
     String text;
     text.AppendWithFormat("Points:\t\t %d", points_);
@@ -73,6 +80,8 @@ void Hud::AddPoints(int points) {
 
 void Hud::AddExtraPoints(int points, const IntVector2& position) {
     points_ += points;
+    ++nearMisses_;
+    GetSubsystem<Telemetry>()->Record(TELEMETRY_NEAR_MISS, points);
 
     WeakPtr<Text> text(new Text(context_));
     String msg;
@@ -20,6 +20,8 @@ public:
     void SetDefaultStyle(XMLFile* style);
     void Reset(const String& informationText);
     int GetPoints();
+    /// Return number of near misses rewarded with extra points since the last reset.
+    unsigned GetNearMisses() const;
     void AddPoints(int points);
     void AddExtraPoints(int points, const IntVector2& position);
 
@@ -29,4 +31,5 @@ private:
     SharedPtr<Text> pointsValue_;
     SharedPtr<Text> information_;
     int points_;
+    unsigned nearMisses_;
 };
@@ -0,0 +1,56 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/WorkQueue.h>
+
+#include "JobSystem.h"
+
+static void RunChunk(const WorkItem* item, unsigned threadIndex) {
+    auto* function = static_cast<const JobSystem::ChunkFunction*>(item->aux_);
+    (*function)((unsigned)(size_t)item->start_, (unsigned)(size_t)item->end_);
+}
+
+JobSystem::JobSystem(Context* context): Object(context), threadCount_(0) {
+}
+
+void JobSystem::RegisterObject(Context* context) {
+    context->RegisterSubsystem<JobSystem>();
+}
+
+void JobSystem::SetThreadCount(unsigned count) {
+    threadCount_ = count ? Min(count, GetMaxThreadCount()) : 0;
+}
+
+unsigned JobSystem::GetThreadCount() const {
+    return threadCount_ ? threadCount_ : GetMaxThreadCount();
+}
+
+unsigned JobSystem::GetMaxThreadCount() const {
+    return GetSubsystem<WorkQueue>()->GetNumThreads() + 1;
+}
+
+void JobSystem::ParallelFor(unsigned count, unsigned minChunkSize, const ChunkFunction& function) {
+    if (!count) {
+        return;
+    }
+
+    minChunkSize = Max(minChunkSize, 1u);
+    unsigned chunks = Min(GetThreadCount(), (count + minChunkSize - 1) / minChunkSize);
+    if (chunks <= 1) {
+        function(0, count);
+        return;
+    }
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    unsigned chunkSize = (count + chunks - 1) / chunks;
+    for (unsigned begin = 0; begin < count; begin += chunkSize) {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = RunChunk;
+        item->start_ = (void*)(size_t)begin;
+        item->end_ = (void*)(size_t)Min(begin + chunkSize, count);
+        item->aux_ = const_cast<ChunkFunction*>(&function);
+        queue->AddWorkItem(item);
+    }
+
+    // The main thread takes chunks too until the queue is drained
+    queue->Complete(M_MAX_UNSIGNED);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include <functional>
+
+using namespace Urho3D;
+
+/// Splits game-side work into chunks and runs them on the engine work queue.
+class JobSystem: public Object {
+
+    URHO3D_OBJECT(JobSystem, Object)
+
+public:
+    /// Function processing the index range [begin, end).
+    typedef std::function<void(unsigned begin, unsigned end)> ChunkFunction;
+
+    explicit JobSystem(Context* context);
+    static void RegisterObject(Context* context);
+
+    /// Set number of threads taking part in jobs, main thread included. Zero uses all work queue threads.
+    void SetThreadCount(unsigned count);
+    unsigned GetThreadCount() const;
+    /// Return number of work queue threads plus the main thread.
+    unsigned GetMaxThreadCount() const;
+
+    /// Run function over [0, count) in chunks of at least minChunkSize and wait for completion.
+    /// Chunks write only to their own range, so the result does not depend on the thread count.
+    void ParallelFor(unsigned count, unsigned minChunkSize, const ChunkFunction& function);
+
+private:
+    unsigned threadCount_;
+};
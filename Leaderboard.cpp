@@ -0,0 +1,267 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+
+#include <cstddef>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Leaderboard.h"
+
+static unsigned Checksum(const void* data, unsigned size) {
+    // FNV-1a, seeded so an all-zero record or header never validates
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    unsigned hash = 2166136261u;
+    for (unsigned i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+Leaderboard::Leaderboard(Context* context):
+    Object(context),
+    file_(-1),
+    data_(nullptr),
+    mappedSize_(0),
+    durable_(true),
+    count_(0),
+    sequence_(0) {
+}
+
+Leaderboard::~Leaderboard() {
+    Close();
+}
+
+void Leaderboard::RegisterObject(Context* context) {
+    context->RegisterSubsystem<Leaderboard>();
+}
+
+bool Leaderboard::Open(const String& fileName) {
+    Close();
+
+#ifdef _WIN32
+    URHO3D_LOGERROR("Leaderboard: memory-mapped log is not supported on this platform");
+    return false;
+#else
+    file_ = open(GetNativePath(fileName).CString(), O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (file_ < 0 || fstat(file_, &info) != 0) {
+        URHO3D_LOGERRORF("Leaderboard: could not open %s", fileName.CString());
+        Close();
+        return false;
+    }
+
+    unsigned capacitySize = LEADERBOARD_RECORDS_OFFSET + LEADERBOARD_INITIAL_CAPACITY * sizeof(LeaderboardRecord);
+    if (!Map(Max((unsigned)info.st_size, capacitySize))) {
+        URHO3D_LOGERRORF("Leaderboard: could not map %s", fileName.CString());
+        Close();
+        return false;
+    }
+
+    const LeaderboardHeader* header = nullptr;
+    for (unsigned slot = 0; slot < 2; ++slot) {
+        const LeaderboardHeader& candidate = Header(slot);
+        if (candidate.magic_ == LEADERBOARD_MAGIC && candidate.topCount_ <= LEADERBOARD_SIZE &&
+            candidate.checksum_ == Checksum(&candidate, offsetof(LeaderboardHeader, checksum_)) &&
+            (!header || candidate.sequence_ > header->sequence_)) {
+            header = &candidate;
+        }
+    }
+
+    unsigned capacity = (mappedSize_ - LEADERBOARD_RECORDS_OFFSET) / sizeof(LeaderboardRecord);
+    count_ = 0;
+    sequence_ = 0;
+    top_.clear();
+    if (header) {
+        count_ = Min(header->count_, capacity);
+        sequence_ = header->sequence_;
+        for (unsigned i = 0; i < header->topCount_; ++i) {
+            if (header->top_[i] < count_) {
+                top_.push_back(header->top_[i]);
+            }
+        }
+    }
+
+    // Records completed after the last header commit are intact, a torn record stops the recovery and is overwritten
+    unsigned recovered = 0;
+    while (count_ < capacity && IsValid(Record(count_))) {
+        Index(count_++);
+        ++recovered;
+    }
+
+    if (recovered || !header) {
+        Commit();
+    }
+
+    URHO3D_LOGINFOF("Leaderboard: %u records, %u recovered after the last commit", count_, recovered);
+    return true;
+#endif
+}
+
+void Leaderboard::Close() {
+#ifndef _WIN32
+    if (data_) {
+        msync(data_, mappedSize_, MS_SYNC);
+    }
+    Unmap();
+
+    if (file_ >= 0) {
+        close(file_);
+        file_ = -1;
+    }
+#endif
+
+    count_ = 0;
+    top_.clear();
+}
+
+bool Leaderboard::IsOpen() const {
+    return data_ != nullptr;
+}
+
+bool Leaderboard::Append(unsigned score, unsigned runId, float duration, unsigned nearMisses) {
+    if (!data_) {
+        return false;
+    }
+
+    if (LEADERBOARD_RECORDS_OFFSET + (count_ + 1) * sizeof(LeaderboardRecord) > mappedSize_ && !Map(mappedSize_ * 2)) {
+        URHO3D_LOGERROR("Leaderboard: could not grow the log");
+        return false;
+    }
+
+    // The record is durable before the header counts it, so a commit never points past intact data
+    LeaderboardRecord& record = Record(count_);
+    record.magic_ = LEADERBOARD_MAGIC;
+    record.score_ = score;
+    record.runId_ = runId;
+    record.duration_ = duration;
+    record.nearMisses_ = nearMisses;
+    record.timestamp_ = Time::GetTimeSinceEpoch();
+    record.reserved_ = 0;
+    record.checksum_ = Checksum(&record, offsetof(LeaderboardRecord, checksum_));
+    Flush(LEADERBOARD_RECORDS_OFFSET + count_ * sizeof(LeaderboardRecord), sizeof(LeaderboardRecord));
+
+    Index(count_++);
+    Commit();
+
+    return true;
+}
+
+void Leaderboard::SetDurable(bool durable) {
+    durable_ = durable;
+}
+
+unsigned Leaderboard::GetRecordCount() const {
+    return count_;
+}
+
+const LeaderboardRecord& Leaderboard::GetRecord(unsigned index) const {
+    return Record(index);
+}
+
+void Leaderboard::GetTop(std::vector<LeaderboardRecord>& result, unsigned count) const {
+    for (unsigned i = 0; i < top_.size() && i < count; ++i) {
+        result.push_back(Record(top_[i]));
+    }
+}
+
+bool Leaderboard::Map(unsigned size) {
+#ifdef _WIN32
+    return false;
+#else
+    // The old mapping is released only once the new one exists, so a failed grow leaves every record readable
+    struct stat info;
+    if (fstat(file_, &info) != 0 || ((unsigned)info.st_size < size && ftruncate(file_, size) != 0)) {
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    Unmap();
+    data_ = static_cast<unsigned char*>(data);
+    mappedSize_ = size;
+    return true;
+#endif
+}
+
+void Leaderboard::Unmap() {
+#ifndef _WIN32
+    if (data_) {
+        munmap(data_, mappedSize_);
+        data_ = nullptr;
+        mappedSize_ = 0;
+    }
+#endif
+}
+
+void Leaderboard::Flush(unsigned offset, unsigned size) {
+#ifndef _WIN32
+    if (!durable_) {
+        return;
+    }
+
+    unsigned pageSize = (unsigned)sysconf(_SC_PAGESIZE);
+    unsigned start = offset - offset % pageSize;
+    msync(data_ + start, offset + size - start, MS_SYNC);
+#endif
+}
+
+void Leaderboard::Index(unsigned index) {
+    // The index only holds the best runs, so keeping it sorted on append is a short insertion
+    unsigned score = Record(index).score_;
+    if (top_.size() >= LEADERBOARD_SIZE && score <= Record(top_.back()).score_) {
+        return;
+    }
+
+    auto it = top_.begin();
+    while (it != top_.end() && Record(*it).score_ >= score) {
+        ++it;
+    }
+    top_.insert(it, index);
+
+    if (top_.size() > LEADERBOARD_SIZE) {
+        top_.pop_back();
+    }
+}
+
+void Leaderboard::Commit() {
+    ++sequence_;
+    unsigned slot = sequence_ % 2;
+
+    LeaderboardHeader& header = Header(slot);
+    memset(&header, 0, sizeof(LeaderboardHeader));
+    header.magic_ = LEADERBOARD_MAGIC;
+    header.sequence_ = sequence_;
+    header.count_ = count_;
+    header.topCount_ = top_.size();
+    for (unsigned i = 0; i < top_.size(); ++i) {
+        header.top_[i] = top_[i];
+    }
+    header.checksum_ = Checksum(&header, offsetof(LeaderboardHeader, checksum_));
+
+    Flush(slot * LEADERBOARD_HEADER_SLOT, sizeof(LeaderboardHeader));
+}
+
+bool Leaderboard::IsValid(const LeaderboardRecord& record) const {
+    return record.magic_ == LEADERBOARD_MAGIC && record.checksum_ == Checksum(&record, offsetof(LeaderboardRecord, checksum_));
+}
+
+LeaderboardRecord& Leaderboard::Record(unsigned index) const {
+    return *reinterpret_cast<LeaderboardRecord*>(data_ + LEADERBOARD_RECORDS_OFFSET + index * sizeof(LeaderboardRecord));
+}
+
+LeaderboardHeader& Leaderboard::Header(unsigned slot) const {
+    return *reinterpret_cast<LeaderboardHeader*>(data_ + slot * LEADERBOARD_HEADER_SLOT);
+}
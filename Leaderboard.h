@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include <vector>
+
+using namespace Urho3D;
+
+const unsigned LEADERBOARD_SIZE = 10;
+const unsigned LEADERBOARD_MAGIC = 0x4c425050;
+/// Each header slot has its own disk sector, so a torn write damages at most the slot being written.
+const unsigned LEADERBOARD_HEADER_SLOT = 512;
+const unsigned LEADERBOARD_RECORDS_OFFSET = 2 * LEADERBOARD_HEADER_SLOT;
+const unsigned LEADERBOARD_INITIAL_CAPACITY = 1024;
+const String LEADERBOARD_FILE = "Leaderboard.log";
+
+/// One finished run. Records are appended and never modified.
+struct LeaderboardRecord {
+    unsigned magic_;
+    unsigned score_;
+    /// Tells runs apart. Not a random seed, the run cannot be replayed from it.
+    unsigned runId_;
+    float duration_;
+    unsigned nearMisses_;
+    unsigned timestamp_;
+    unsigned reserved_;
+    unsigned checksum_;
+};
+
+static_assert(sizeof(LeaderboardRecord) == 32, "Leaderboard records are fixed-size");
+
+/// Committed state, written alternately to two slots. The valid slot with the higher sequence wins.
+struct LeaderboardHeader {
+    unsigned magic_;
+    unsigned sequence_;
+    unsigned count_;
+    unsigned topCount_;
+    /// Record indices of the best runs, best first.
+    unsigned top_[LEADERBOARD_SIZE];
+    unsigned checksum_;
+};
+
+/// Local leaderboard in an append-only, memory-mapped log of fixed-size records. Every record and header slot carries a
+/// checksum: a power cut mid-append loses at most the record being written, records completed after the last header commit
+/// are recovered on open. The best runs are kept as an index in the header, so neither opening nor a lookup scans the log.
+class Leaderboard: public Object {
+
+    URHO3D_OBJECT(Leaderboard, Object)
+
+public:
+    explicit Leaderboard(Context* context);
+    ~Leaderboard();
+    static void RegisterObject(Context* context);
+
+    bool Open(const String& fileName);
+    void Close();
+    bool IsOpen() const;
+
+    /// Append a run and update the index. Flushed to storage before returning unless durability is disabled.
+    bool Append(unsigned score, unsigned runId, float duration, unsigned nearMisses);
+    /// Disable flushing after each append. Only for filling large logs in the benchmark, Close still flushes.
+    void SetDurable(bool durable);
+
+    unsigned GetRecordCount() const;
+    const LeaderboardRecord& GetRecord(unsigned index) const;
+    /// Collect up to count best runs, best first, from the index.
+    void GetTop(std::vector<LeaderboardRecord>& result, unsigned count = LEADERBOARD_SIZE) const;
+
+private:
+    bool Map(unsigned size);
+    void Unmap();
+    void Flush(unsigned offset, unsigned size);
+    void Index(unsigned index);
+    void Commit();
+    bool IsValid(const LeaderboardRecord& record) const;
+    LeaderboardRecord& Record(unsigned index) const;
+    LeaderboardHeader& Header(unsigned slot) const;
+
+    int file_;
+    unsigned char* data_;
+    unsigned mappedSize_;
+    bool durable_;
+
+    unsigned count_;
+    unsigned sequence_;
+    std::vector<unsigned> top_;
+};
@@ -8,18 +8,22 @@
 #include <Urho3D/Physics/RigidBody.h>
 
 #include "Obstacle.h"
-#include "CollisionLayers.h"
+#include "ObstacleSystem.h"
+#include "GameConfig.h"
 
-Obstacle::Obstacle(Context* context) : LogicComponent(context), floatFactor_(0) {
-    SetUpdateEventMask(USE_FIXEDUPDATE);
+Obstacle::Obstacle(Context* context) : Component(context), floatFactor_(0), floatSpeed_(1.0f), systemIndex_(M_MAX_UNSIGNED) {
 }
 
 void Obstacle::RegisterObject(Context* context) {
     context->RegisterFactory<Obstacle>();
+
+    URHO3D_ATTRIBUTE("Float Factor", float, floatFactor_, 0.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Float Speed", float, floatSpeed_, 1.0f, AM_DEFAULT);
 }
 
-void Obstacle::Init(Model* model, Material* material) {
-    node_->SetScale(Vector3::ONE * 0.4f);
+void Obstacle::Init(Model* model, Material* material, float unitScale) {
+    node_->SetScale(Vector3::ONE * Config().obstacleScale_ * unitScale);
+    floatSpeed_ = unitScale;
     node_->SetRotation(Quaternion(Random(180), Vector3::DOWN) * Quaternion(Random(180), Vector3::RIGHT));
 
     auto* object = node_->CreateComponent<StaticModel>();
@@ -27,10 +31,31 @@ void Obstacle::Init(Model* model, Material* material) {
     object->SetMaterial(material);
 
     auto* body = node_->CreateComponent<RigidBody>();
-    body->SetCollisionLayer(LAYER_WORLD | LAYER_OBSTACLE);
+    body->SetCollisionLayer(Config().layerWorld_ | Config().layerObstacle_);
     node_->CreateComponent<CollisionShape>()->SetGImpactMesh(model);
 }
 
-void Obstacle::FixedUpdate(float timeStep) {
-    node_->SetPosition(node_->GetPosition() + Sin(floatFactor_++) * timeStep * Vector3::ONE);
+Vector3 Obstacle::Step(float timeStep) {
+    return node_->GetPosition() + Sin(floatFactor_++) * timeStep * floatSpeed_ * Vector3::ONE;
+}
+
+void Obstacle::SetSystemIndex(unsigned index) {
+    systemIndex_ = index;
+}
+
+unsigned Obstacle::GetSystemIndex() const {
+    return systemIndex_;
+}
+
+void Obstacle::OnSceneSet(Scene* scene) {
+    auto* obstacleSystem = GetSubsystem<ObstacleSystem>();
+    if (!obstacleSystem) {
+        return;
+    }
+
+    if (scene) {
+        obstacleSystem->AddObstacle(this);
+    } else {
+        obstacleSystem->RemoveObstacle(this);
+    }
 }
@@ -1,12 +1,12 @@
 #pragma once
 
-#include <Urho3D/Scene/LogicComponent.h>
+#include <Urho3D/Scene/Component.h>
 
 using namespace Urho3D;
 
-class Obstacle: public LogicComponent {
+class Obstacle: public Component {
 
-    URHO3D_OBJECT(Obstacle, LogicComponent)
+    URHO3D_OBJECT(Obstacle, Component)
 
 public:
     explicit Obstacle(Context* context);
@@ -14,12 +14,22 @@ public:
     static void RegisterObject(Context* context);
 
     /// Initialize the vehicle. Create rendering and physics components. Called by the application.
-    void Init(Model* model, Material* material);
+    /// Unit scale is the size of one pipe model unit in the parent node's space.
+    void Init(Model* model, Material* material, float unitScale);
 
-    /// Handle physics world update. Called by LogicComponent base class.
-    void FixedUpdate(float timeStep) override;
+    /// Advance floating motion and return the new node position. Touches only this obstacle, safe to call from worker threads.
+    Vector3 Step(float timeStep);
+
+    /// Set and return the slot in the obstacle system, M_MAX_UNSIGNED when not registered. Used by ObstacleSystem.
+    void SetSystemIndex(unsigned index);
+    unsigned GetSystemIndex() const;
+
+protected:
+    /// Register to the obstacle system when added to the scene, unregister when removed.
+    void OnSceneSet(Scene* scene) override;
 
 private:
     float floatFactor_;
+    float floatSpeed_;
+    unsigned systemIndex_;
 };
-
@@ -0,0 +1,80 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Profiler.h>
+
+#include <Urho3D/Physics/PhysicsEvents.h>
+
+#include <Urho3D/Scene/Node.h>
+
+#include "JobSystem.h"
+#include "Obstacle.h"
+#include "ObstacleSystem.h"
+
+ObstacleSystem::ObstacleSystem(Context* context): Object(context) {
+    SubscribeToEvent(E_PHYSICSPRESTEP, URHO3D_HANDLER(ObstacleSystem, HandlePhysicsPreStep));
+}
+
+void ObstacleSystem::RegisterObject(Context* context) {
+    context->RegisterSubsystem<ObstacleSystem>();
+}
+
+void ObstacleSystem::AddObstacle(Obstacle* obstacle) {
+    if (obstacle->GetSystemIndex() != M_MAX_UNSIGNED) {
+        return;
+    }
+
+    obstacle->SetSystemIndex(obstacles_.size());
+    obstacles_.push_back(obstacle);
+}
+
+void ObstacleSystem::RemoveObstacle(Obstacle* obstacle) {
+    unsigned index = obstacle->GetSystemIndex();
+    if (index >= obstacles_.size() || obstacles_[index] != obstacle) {
+        return;
+    }
+
+    // Pruning removes whole generations, so removal is a constant-time swap with the last obstacle. The resulting
+    // order depends only on the add and remove sequence, never on the thread count
+    Obstacle* last = obstacles_.back();
+    obstacles_[index] = last;
+    last->SetSystemIndex(index);
+    obstacles_.pop_back();
+    obstacle->SetSystemIndex(M_MAX_UNSIGNED);
+}
+
+void ObstacleSystem::Update(float timeStep) {
+    URHO3D_PROFILE(UpdateObstacles);
+
+    unsigned count = obstacles_.size();
+    positions_.resize(count);
+    active_.resize(count);
+
+    // Enabled state is read on the main thread, std::vector<bool> elements must not be written concurrently
+    for (unsigned i = 0; i < count; ++i) {
+        active_[i] = obstacles_[i]->IsEnabledEffective();
+    }
+
+    GetSubsystem<JobSystem>()->ParallelFor(count, OBSTACLE_CHUNK_SIZE, [this, timeStep](unsigned begin, unsigned end) {
+        for (unsigned i = begin; i < end; ++i) {
+            if (active_[i]) {
+                positions_[i] = obstacles_[i]->Step(timeStep);
+            }
+        }
+    });
+
+    // Scene graph is not thread-safe, so dirtying transforms happens here
+    for (unsigned i = 0; i < count; ++i) {
+        if (active_[i]) {
+            obstacles_[i]->GetNode()->SetPosition(positions_[i]);
+        }
+    }
+}
+
+unsigned ObstacleSystem::GetNumObstacles() const {
+    return obstacles_.size();
+}
+
+void ObstacleSystem::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData) {
+    using namespace PhysicsPreStep;
+
+    Update(eventData[P_TIMESTEP].GetFloat());
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include <vector>
+
+using namespace Urho3D;
+
+class Obstacle;
+
+const unsigned OBSTACLE_CHUNK_SIZE = 16;
+
+/// Updates all obstacles of the scene in one batch on each physics step.
+class ObstacleSystem: public Object {
+
+    URHO3D_OBJECT(ObstacleSystem, Object)
+
+public:
+    explicit ObstacleSystem(Context* context);
+    static void RegisterObject(Context* context);
+
+    void AddObstacle(Obstacle* obstacle);
+    void RemoveObstacle(Obstacle* obstacle);
+
+    /// Step all enabled obstacles. Positions are computed in parallel and applied on the main thread in a deterministic order.
+    void Update(float timeStep);
+
+    unsigned GetNumObstacles() const;
+
+    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
+
+private:
+    std::vector<Obstacle*> obstacles_;
+    std::vector<Vector3> positions_;
+    std::vector<bool> active_;
+};
@@ -0,0 +1,96 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+
+#include <Urho3D/Graphics/GraphicsEvents.h>
+
+#include <Urho3D/Physics/PhysicsEvents.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+
+#include "PerformanceMonitor.h"
+
+PerformanceMonitor::PerformanceMonitor(Context* context):
+    Object(context),
+    framePhysicsTime_(0),
+    frameStarted_(false),
+    workMeasured_(false),
+    frameTime_(0.0f),
+    workTime_(0.0f),
+    physicsTime_(0.0f),
+    physicsStepTime_(0.0f),
+    broadphasePairs_(0.0f) {
+
+    SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(PerformanceMonitor, HandleBeginFrame));
+    SubscribeToEvent(E_ENDRENDERING, URHO3D_HANDLER(PerformanceMonitor, HandleEndRendering));
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(PerformanceMonitor, HandleEndFrame));
+    SubscribeToEvent(E_PHYSICSPRESTEP, URHO3D_HANDLER(PerformanceMonitor, HandlePhysicsPreStep));
+    SubscribeToEvent(E_PHYSICSPOSTSTEP, URHO3D_HANDLER(PerformanceMonitor, HandlePhysicsPostStep));
+}
+
+void PerformanceMonitor::RegisterObject(Context* context) {
+    context->RegisterSubsystem<PerformanceMonitor>();
+}
+
+float PerformanceMonitor::GetFrameTime() const {
+    return frameTime_;
+}
+
+float PerformanceMonitor::GetWorkTime() const {
+    return workTime_;
+}
+
+float PerformanceMonitor::GetPhysicsTime() const {
+    return physicsTime_;
+}
+
+float PerformanceMonitor::GetPhysicsStepTime() const {
+    return physicsStepTime_;
+}
+
+float PerformanceMonitor::GetBroadphasePairs() const {
+    return broadphasePairs_;
+}
+
+void PerformanceMonitor::HandleBeginFrame(StringHash eventType, VariantMap& eventData) {
+    if (frameStarted_) {
+        Smooth(frameTime_, frameTimer_.GetUSec(false) / 1000.0f);
+    }
+
+    frameTimer_.Reset();
+    framePhysicsTime_ = 0;
+    frameStarted_ = true;
+    workMeasured_ = false;
+}
+
+void PerformanceMonitor::HandleEndRendering(StringHash eventType, VariantMap& eventData) {
+    // Sent before the buffer swap, so vsync waits are not counted as work
+    Smooth(workTime_, frameTimer_.GetUSec(false) / 1000.0f);
+    workMeasured_ = true;
+}
+
+void PerformanceMonitor::HandleEndFrame(StringHash eventType, VariantMap& eventData) {
+    // Headless runs do not render, the whole frame is work then
+    if (!workMeasured_) {
+        Smooth(workTime_, frameTimer_.GetUSec(false) / 1000.0f);
+    }
+
+    Smooth(physicsTime_, framePhysicsTime_ / 1000.0f);
+}
+
+void PerformanceMonitor::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData) {
+    stepTimer_.Reset();
+}
+
+void PerformanceMonitor::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData) {
+    long long stepTime = stepTimer_.GetUSec(false);
+    framePhysicsTime_ += stepTime;
+    Smooth(physicsStepTime_, stepTime / 1000.0f);
+
+    auto* world = static_cast<PhysicsWorld*>(eventData[PhysicsPostStep::P_WORLD].GetPtr());
+    Smooth(broadphasePairs_, (float)world->GetWorld()->getPairCache()->getNumOverlappingPairs());
+}
+
+void PerformanceMonitor::Smooth(float& value, float sample) {
+    value = value ? Lerp(value, sample, PERFORMANCE_SMOOTHING) : sample;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+using namespace Urho3D;
+
+/// Weight of the latest sample in the smoothed timings.
+const float PERFORMANCE_SMOOTHING = 0.1f;
+
+/// Measures frame, CPU work and physics step times. All times are smoothed and in milliseconds.
+class PerformanceMonitor: public Object {
+
+    URHO3D_OBJECT(PerformanceMonitor, Object)
+
+public:
+    explicit PerformanceMonitor(Context* context);
+    static void RegisterObject(Context* context);
+
+    /// Return time between frame starts, including vsync and frame limiter waits.
+    float GetFrameTime() const;
+    /// Return time from frame start until rendering commands are submitted.
+    float GetWorkTime() const;
+    /// Return time spent in physics steps per frame.
+    float GetPhysicsTime() const;
+    /// Return time of a single physics step.
+    float GetPhysicsStepTime() const;
+    /// Return number of overlapping pairs in the physics broadphase after a step.
+    float GetBroadphasePairs() const;
+
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+    void HandleEndRendering(StringHash eventType, VariantMap& eventData);
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
+    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
+
+private:
+    void Smooth(float& value, float sample);
+
+    HiresTimer frameTimer_;
+    HiresTimer stepTimer_;
+    long long framePhysicsTime_;
+    bool frameStarted_;
+    bool workMeasured_;
+
+    float frameTime_;
+    float workTime_;
+    float physicsTime_;
+    float physicsStepTime_;
+    float broadphasePairs_;
+};
@@ -3,6 +3,7 @@
 #include <Urho3D/Core/Context.h>
 
 #include <Urho3D/Graphics/Geometry.h>
+#include <Urho3D/Graphics/IndexBuffer.h>
 #include <Urho3D/Graphics/Light.h>
 #include <Urho3D/Graphics/Material.h>
 #include <Urho3D/Graphics/Model.h>
@@ -10,6 +11,8 @@
 #include <Urho3D/Graphics/VertexBuffer.h>
 
 #include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
 
 #include <Urho3D/Math/MathDefs.h>
 
@@ -21,13 +24,28 @@
 #include <Urho3D/Scene/Scene.h>
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
-#include "CollisionLayers.h"
+#include "DifficultyController.h"
+#include "GameConfig.h"
+#include "JobSystem.h"
 #include "Obstacle.h"
+#include "Probe.h"
+#include "Telemetry.h"
 #include "PipeGenerator.h"
 
-PipeGenerator::PipeGenerator(Context *context): Object(context), pipeModels_(), nextPos_(Vector3::ZERO) {
+PipeGenerator::PipeGenerator(Context *context):
+    Object(context),
+    pipeModels_(),
+    probeRadius_(0.0f),
+    placementChecks_(true),
+    bakeChunks_(true),
+    chunkCount_(0),
+    placementStats_(),
+    nextPos_(Vector3::ZERO),
+    revision_(0),
+    snapshotOffset_(0) {
 }
 
 void PipeGenerator::RegisterObject(Context* context) {
@@ -48,6 +66,21 @@ void PipeGenerator::LoadModels() {
     }
     pipeMaterial_ = cache->GetResource<Material>("Materials/RustyMetalMaterial.xml");
 
+    // Baked chunks merge pipes into one vertex buffer, which needs a common vertex format
+    for (auto* model : pipeModels_) {
+        for (unsigned i = 0; i < model->GetNumGeometries(); ++i) {
+            Geometry* geometry = model->GetGeometry(i, 0);
+            if (geometry->GetVertexBuffer(0)->GetElements() != pipeModels_.front()->GetGeometry(0, 0)->GetVertexBuffer(0)->GetElements()) {
+                URHO3D_LOGWARNINGF("Pipe model %s has a different vertex format, chunk baking disabled", model->GetName().CString());
+                bakeChunks_ = false;
+            }
+        }
+    }
+
+    for (auto* model : pipeModels_) {
+        pipeProfiles_.push_back(ScanProfile(model));
+    }
+
     for (const auto& resourceDir : cache->GetResourceDirs()) {
         std::vector<String> tmp;
         String fullDir = resourceDir + TRASH_MODEL_DIR;
@@ -58,6 +91,15 @@ void PipeGenerator::LoadModels() {
         });
     }
 
+    // Obstacles get a random rotation, so their bounds are spheres around the model origin
+    for (auto* model : trashModels_) {
+        const BoundingBox& box = model->GetBoundingBox();
+        trashRadii_.push_back((box.Center().Length() + box.HalfSize().Length()) * Config().obstacleScale_);
+    }
+
+    const BoundingBox& probeBox = cache->GetResource<Model>(PROBE_MODEL)->GetBoundingBox();
+    probeRadius_ = probeBox.HalfSize().Length() / Config().pipeScale_;
+
     for (const auto& resourceDir : cache->GetResourceDirs()) {
         std::vector<String> tmp;
         String fullDir = resourceDir + TRASH_MATERIAL_DIR;
@@ -69,51 +111,185 @@ void PipeGenerator::LoadModels() {
     }
 }
 
+PipeProfile PipeGenerator::ScanProfile(Model* model) {
+    auto buff = model->GetVertexBuffers()[0];
+    unsigned char* data = buff->GetShadowData();
+
+    unsigned vertexCount = buff->GetVertexCount();
+    unsigned vertexSize = buff->GetVertexSize();
+
+    unsigned vertexStart = VertexBuffer::GetElementOffset(buff->GetElements(), TYPE_VECTOR3, SEM_POSITION);
+
+    const BoundingBox& box = model->GetBoundingBox();
+    unsigned sliceCount = (unsigned)CeilToInt((box.max_.y_ - box.min_.y_) / PIPE_PROFILE_SLICE) + 1;
+
+    PipeProfile profile;
+    profile.bendTop_ = -M_INFINITY;
+    profile.bendBottom_ = M_INFINITY;
+    profile.top_ = box.max_.y_;
+    profile.centers_.resize(sliceCount, Vector2::ZERO);
+    profile.radii_.resize(sliceCount, M_INFINITY);
+    std::vector<unsigned> counts(sliceCount, 0);
+
+    // Walls of a straight section lie on the pipe radius cylinder around the model Y axis, anything else is a bend or a chamber
+    float pipeRadius = Config().pipeRadius_;
+    for (unsigned j = 0; j < vertexCount; ++j) {
+        const Vector3& vertex = *((const Vector3*)(&data[vertexStart + j * vertexSize]));
+
+        float radius = Vector2(vertex.x_, vertex.z_).Length();
+        if (radius < pipeRadius * 0.9f || radius > pipeRadius * 1.05f) {
+            profile.bendTop_ = Max(profile.bendTop_, vertex.y_);
+            profile.bendBottom_ = Min(profile.bendBottom_, vertex.y_);
+        }
+
+        unsigned slice = profile.GetSlice(vertex.y_);
+        profile.centers_[slice] += Vector2(vertex.x_, vertex.z_);
+        ++counts[slice];
+    }
+
+    for (unsigned j = 0; j < sliceCount; ++j) {
+        if (counts[j]) {
+            profile.centers_[j] /= (float)counts[j];
+        } else {
+            profile.centers_[j] = j ? profile.centers_[j - 1] : Vector2::ZERO;
+        }
+    }
+
+    for (unsigned j = 0; j < vertexCount; ++j) {
+        const Vector3& vertex = *((const Vector3*)(&data[vertexStart + j * vertexSize]));
+
+        unsigned slice = profile.GetSlice(vertex.y_);
+        float radius = (Vector2(vertex.x_, vertex.z_) - profile.centers_[slice]).Length();
+        profile.radii_[slice] = Min(profile.radii_[slice], radius);
+    }
+
+    // Slices without vertices are spanned by long wall triangles of the pipe radius
+    for (auto& radius : profile.radii_) {
+        if (radius == M_INFINITY) {
+            radius = pipeRadius;
+        }
+    }
+
+    return profile;
+}
+
+unsigned PipeProfile::GetSlice(float y) const {
+    int slice = FloorToInt((top_ - y) / PIPE_PROFILE_SLICE);
+    return (unsigned)Clamp(slice, 0, (int)centers_.size() - 1);
+}
+
 void PipeGenerator::Start() {
     GeneratePipes();
 }
 
 void PipeGenerator::GeneratePipes() {
-    if (pipes_.size() > 10) {
-        for (std::vector<Node*>::iterator it = pipes_.begin(); it != pipes_.end() - 5; ++it) {
-            (*it)->Remove();
-        }
-        pipes_.erase(pipes_.begin(), pipes_.end() - 5);
+    const GameConfig& config = Config();
+    if (pipes_.size() > config.pipesKeptMax_) {
+        RemovePipes(pipes_.size() - config.pipesKept_);
     }
 
-    for (int j = 0; j < 3; ++j) {
-        Node* pipeNode = scene_->CreateChild("Pipe");
-        pipeNode->SetScale(5);
+    // Pipes never move, so a baked generation is a single node with world-space geometry and lights and obstacles
+    // directly below it, instead of a scaled and rotated node per pipe
+    Node* chunk = bakeChunks_ ? scene_->CreateChild("PipeChunk") : nullptr;
+
+    std::vector<PipeLayout> layouts(config.pipesPerGeneration_);
+    for (auto& layout : layouts) {
+        Quaternion rotation(30 * (Rand() % 15), Vector3::DOWN);
+        unsigned modelIndex = Rand() % pipeModels_.size();
+        auto* model = pipeModels_[modelIndex];
+
+        if (chunk) {
+            layout.node_ = chunk;
+            layout.transform_ = Matrix3x4(nextPos_, rotation, config.pipeScale_);
+            layout.rotation_ = rotation;
+            layout.unitScale_ = config.pipeScale_;
+        } else {
+            Node* pipeNode = scene_->CreateChild("Pipe");
+            pipeNode->SetScale(config.pipeScale_);
+            pipeNode->SetRotation(rotation);
+            pipeNode->SetPosition(nextPos_);
+
+            auto* object = pipeNode->CreateComponent<StaticModel>();
+            object->SetModel(model);
+            object->SetMaterial(pipeMaterial_);
+
+            auto* body = pipeNode->CreateComponent<RigidBody>();
+            body->SetCollisionLayer(config.layerWorld_ | config.layerPipe_);
+            auto* shape = pipeNode->CreateComponent<CollisionShape>();
+            shape->SetGImpactMesh(object->GetModel(), 0);
+
+            layout.node_ = pipeNode;
+            layout.transform_ = Matrix3x4::IDENTITY;
+            layout.rotation_ = Quaternion::IDENTITY;
+            layout.unitScale_ = 1.0f;
+        }
+
+        layout.model_ = model;
+        layout.profile_ = &pipeProfiles_[modelIndex];
+        layout.obstacleCount_ = 0;
+        layout.stats_ = PlacementStats();
+        if (nextPos_ != Vector3::ZERO) { //do not generate obstacles for very first pipe
+            PickObstacles(layout);
+        }
 
-        pipeNode->SetRotation(Quaternion(30 * (Rand() % 15), Vector3::DOWN));
-        pipeNode->SetPosition(nextPos_);
+        pipes_.push_back(layout.node_);
 
-        auto* object = pipeNode->CreateComponent<StaticModel>();
-            
-        auto* model = pipeModels_[Rand() % pipeModels_.size()];
-        object->SetModel(model);
-        object->SetMaterial(pipeMaterial_);
+        float scale = config.pipeScale_;
+        const PipeProfile& profile = pipeProfiles_[modelIndex];
+        PipeSegment segment;
+        segment.top_ = nextPos_.y_ + model->GetBoundingBox().max_.y_ * scale;
+        segment.bottom_ = nextPos_.y_ + model->GetBoundingBox().min_.y_ * scale;
+        segment.bendTop_ = nextPos_.y_ + profile.bendTop_ * scale;
+        segment.bendBottom_ = nextPos_.y_ + profile.bendBottom_ * scale;
+        segments_.push_back(segment);
 
-        auto* body = pipeNode->CreateComponent<RigidBody>();
-        body->SetCollisionLayer(LAYER_WORLD | LAYER_PIPE);
-        auto* shape = pipeNode->CreateComponent<CollisionShape>();
-        shape->SetGImpactMesh(object->GetModel(), 0);
+        nextPos_.y_ -= model->GetBoundingBox().Size().y_ * scale;
+    }
 
-        GenerateLights(pipeNode);
-        if (nextPos_ != Vector3::ZERO) { //do not generate obstacles for very first pipe
-            GenerateObstacles(pipeNode);
+    // Layout only reads model shadow data, so pipes are resolved in parallel and nodes are created afterwards in order
+    GetSubsystem<JobSystem>()->ParallelFor(layouts.size(), 1, [this, &layouts](unsigned begin, unsigned end) {
+        for (unsigned i = begin; i < end; ++i) {
+            LayoutPipe(layouts[i]);
         }
+    });
 
-        pipes_.push_back(pipeNode);
+    for (const auto& layout : layouts) {
+        CreateLights(layout);
+        CreateObstacles(layout);
 
-        nextPos_.y_ -= model->GetBoundingBox().Size().y_ * pipeNode->GetScale().y_;
+        placementStats_.placed_ += layout.stats_.placed_;
+        placementStats_.overlaps_ += layout.stats_.overlaps_;
+        placementStats_.blocked_ += layout.stats_.blocked_;
+        placementStats_.seams_ += layout.stats_.seams_;
+        placementStats_.missing_ += layout.stats_.missing_;
     }
+
+    if (chunk) {
+        BakeChunk(chunk, layouts);
+    }
+
+    ++revision_;
+    GetSubsystem<Telemetry>()->Record(TELEMETRY_SEGMENTS, layouts.size());
 }
 
-void PipeGenerator::GenerateLights(Node* pipeNode) {
-    auto* model = pipeNode->GetComponent<StaticModel>()->GetModel();
+void PipeGenerator::PickObstacles(PipeLayout& layout) {
+    const BoundingBox& box = layout.model_->GetBoundingBox();
+
+    // Random numbers are drawn on the main thread so the sequence does not depend on the thread count
+    auto* difficulty = GetSubsystem<DifficultyController>();
+    layout.obstacleCount_ = difficulty->GetObstacleCount();
+    for (unsigned j = 0; j < layout.obstacleCount_ * Config().obstacleCandidates_; ++j) {
+        ObstacleCandidate candidate;
+        candidate.y_ = Random(box.min_.y_, box.max_.y_);
+        candidate.angle_ = Random(360.0f);
+        candidate.depth_ = Config().obstacleMinOffset_ + Random(difficulty->GetObstacleReach());
+        candidate.model_ = Rand() % trashModels_.size();
+        layout.candidates_.push_back(candidate);
+    }
+}
 
-    auto buff = model->GetVertexBuffers()[0];
+void PipeGenerator::LayoutPipe(PipeLayout& layout) const {
+    auto buff = layout.model_->GetVertexBuffers()[0];
     unsigned char* data = buff->GetShadowData();
 
     unsigned vertexCount = buff->GetVertexCount();
@@ -122,48 +298,268 @@ void PipeGenerator::GenerateLights(Node* pipeNode) {
     unsigned normalStart = VertexBuffer::GetElementOffset(buff->GetElements(), TYPE_VECTOR3, SEM_NORMAL);
     unsigned vertexStart = VertexBuffer::GetElementOffset(buff->GetElements(), TYPE_VECTOR3, SEM_POSITION);
 
-    int offset = vertexCount / 4;
+    // More lights than vertices still places one light per vertex
+    int offset = Max(vertexCount / Config().lightsPerPipe_, 1u);
     for (int j = 0; j < vertexCount; j+=offset) {        
         const Vector3& vertex = *((const Vector3*)(&data[(vertexStart + j) * vertexSize]));
         const Vector3& normal = *((const Vector3*)(&data[(vertexStart + j) * vertexSize + normalStart]));
 
-        Node* lightNode = pipeNode->CreateChild("PointLight");
+        layout.lightPositions_.push_back(vertex);
+        layout.lightDirections_.push_back(normal);
+    }
+
+    PlaceObstacles(layout);
+}
+
+void PipeGenerator::PlaceObstacles(PipeLayout& layout) const {
+    // Dart throwing over the tube cross-sections: a candidate is kept only when its bounds stay clear of every
+    // accepted obstacle and the probe still fits through the slab it blocks, so no physics body is created in vain.
+    // Pipes are laid out independently, so obstacles keep a probe diameter from both ends and a seam is always open
+    const BoundingBox& box = layout.model_->GetBoundingBox();
+    float seamBottom = box.min_.y_ + probeRadius_ * 2.0f;
+    float seamTop = box.max_.y_ - probeRadius_ * 2.0f;
+    for (const auto& candidate : layout.candidates_) {
+        if (layout.obstaclePositions_.size() >= layout.obstacleCount_) {
+            break;
+        }
+
+        unsigned slice = layout.profile_->GetSlice(candidate.y_);
+        float distance = layout.profile_->radii_[slice] - candidate.depth_;
+        Vector2 center = layout.profile_->centers_[slice];
+        Vector3 position(center.x_ + distance * Cos(candidate.angle_), candidate.y_, center.y_ + distance * Sin(candidate.angle_));
+        float radius = trashRadii_[candidate.model_];
+
+        if (placementChecks_) {
+            if (position.y_ - radius < seamBottom || position.y_ + radius > seamTop) {
+                ++layout.stats_.seams_;
+                continue;
+            }
+
+            bool overlaps = false;
+            for (unsigned j = 0; j < layout.obstaclePositions_.size(); ++j) {
+                float minDistance = radius + trashRadii_[layout.obstacleModels_[j]];
+                if ((layout.obstaclePositions_[j] - position).LengthSquared() < minDistance * minDistance) {
+                    overlaps = true;
+                    break;
+                }
+            }
+
+            if (overlaps) {
+                ++layout.stats_.overlaps_;
+                continue;
+            }
+
+            if (!HasOpening(layout, position, radius)) {
+                ++layout.stats_.blocked_;
+                continue;
+            }
+        }
+
+        layout.obstaclePositions_.push_back(position);
+        layout.obstacleModels_.push_back(candidate.model_);
+    }
+
+    layout.stats_.placed_ = layout.obstaclePositions_.size();
+    layout.stats_.missing_ = layout.obstacleCount_ - layout.stats_.placed_;
+}
+
+bool PipeGenerator::HasOpening(const PipeLayout& layout, const Vector3& position, float radius) const {
+    // Every obstacle whose height span meets the candidate's is projected onto the candidate's cross-section,
+    // which keeps one straight corridor of probe radius open through the whole span
+    unsigned slice = layout.profile_->GetSlice(position.y_);
+    Vector2 center = layout.profile_->centers_[slice];
+    float reach = layout.profile_->radii_[slice] - probeRadius_;
+    if (reach < 0.0f) {
+        return false;
+    }
+
+    std::vector<Vector3> blockers(1, Vector3(position.x_ - center.x_, position.z_ - center.y_, radius + probeRadius_));
+    for (unsigned j = 0; j < layout.obstaclePositions_.size(); ++j) {
+        const Vector3& other = layout.obstaclePositions_[j];
+        float otherRadius = trashRadii_[layout.obstacleModels_[j]];
+        if (Abs(other.y_ - position.y_) < radius + otherRadius + probeRadius_ * 2.0f) {
+            blockers.push_back(Vector3(other.x_ - center.x_, other.z_ - center.y_, otherRadius + probeRadius_));
+        }
+    }
+
+    for (unsigned ring = 0; ring <= PLACEMENT_RINGS; ++ring) {
+        float distance = reach * ring / PLACEMENT_RINGS;
+        unsigned sectors = ring ? PLACEMENT_SECTORS : 1;
+        for (unsigned sector = 0; sector < sectors; ++sector) {
+            float angle = 360.0f * sector / sectors;
+            Vector2 point(distance * Cos(angle), distance * Sin(angle));
+
+            bool open = true;
+            for (const auto& blocker : blockers) {
+                if ((point - Vector2(blocker.x_, blocker.y_)).LengthSquared() < blocker.z_ * blocker.z_) {
+                    open = false;
+                    break;
+                }
+            }
+
+            if (open) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void PipeGenerator::CreateLights(const PipeLayout& layout) {
+    for (unsigned j = 0; j < layout.lightPositions_.size(); ++j) {
+        Node* lightNode = layout.node_->CreateChild("PointLight");
         auto* light = lightNode->CreateComponent<Light>();
         light->SetLightType(LIGHT_POINT);
-        light->SetRange(150);
-        lightNode->SetPosition(vertex);
-        lightNode->SetDirection(normal);
+        light->SetRange(Config().pipeLightRange_);
+        lightNode->SetPosition(layout.transform_ * layout.lightPositions_[j]);
+        lightNode->SetDirection(layout.rotation_ * layout.lightDirections_[j]);
     }
 }
 
-void PipeGenerator::GenerateObstacles(Node* pipeNode) {
-    auto* model = pipeNode->GetComponent<StaticModel>()->GetModel();
+void PipeGenerator::CreateObstacles(const PipeLayout& layout) {
+    for (unsigned j = 0; j < layout.obstaclePositions_.size(); ++j) {
+        auto* obstacle = RandomObstacle(layout.node_, layout.obstacleModels_[j], layout.unitScale_);
+        obstacle->SetPosition(layout.transform_ * layout.obstaclePositions_[j]);
+    }
+}
 
-    auto buff = model->GetVertexBuffers()[0];
-    unsigned char* data = buff->GetShadowData();
+void PipeGenerator::BakeChunk(Node* chunk, const std::vector<PipeLayout>& layouts) {
+    // Collision keeps the shared pipe meshes as offset shapes of one body, so their cached GImpact data is reused
+    auto* body = chunk->CreateComponent<RigidBody>();
+    body->SetCollisionLayer(Config().layerWorld_ | Config().layerPipe_);
+    for (const auto& layout : layouts) {
+        auto* shape = chunk->CreateComponent<CollisionShape>();
+        shape->SetGImpactMesh(layout.model_, 0, Vector3::ONE * layout.unitScale_, layout.transform_.Translation(), layout.rotation_);
+    }
 
-    unsigned vertexCount = buff->GetVertexCount();
-    unsigned vertexSize = buff->GetVertexSize();
+    // Rendering gets one pre-transformed geometry, all pipes share the vertex format checked in LoadModels and one material
+    const PODVector<VertexElement>& elements = pipeModels_.front()->GetGeometry(0, 0)->GetVertexBuffer(0)->GetElements();
+    unsigned vertexSize = VertexBuffer::GetVertexSize(elements);
+    unsigned positionOffset = VertexBuffer::GetElementOffset(elements, TYPE_VECTOR3, SEM_POSITION);
+    unsigned normalOffset = VertexBuffer::GetElementOffset(elements, TYPE_VECTOR3, SEM_NORMAL);
+    unsigned tangentOffset = VertexBuffer::GetElementOffset(elements, TYPE_VECTOR4, SEM_TANGENT);
+
+    unsigned vertexCount = 0;
+    unsigned indexCount = 0;
+    for (const auto& layout : layouts) {
+        for (unsigned i = 0; i < layout.model_->GetNumGeometries(); ++i) {
+            vertexCount += layout.model_->GetGeometry(i, 0)->GetVertexCount();
+            indexCount += layout.model_->GetGeometry(i, 0)->GetIndexCount();
+        }
+    }
 
-    unsigned normalStart = VertexBuffer::GetElementOffset(buff->GetElements(), TYPE_VECTOR3, SEM_NORMAL);
-    unsigned vertexStart = VertexBuffer::GetElementOffset(buff->GetElements(), TYPE_VECTOR3, SEM_POSITION);
+    PODVector<unsigned char> vertexData(vertexCount * vertexSize);
+    PODVector<unsigned> indexData(indexCount);
+    BoundingBox box;
+    unsigned vertexBase = 0;
+    unsigned indexBase = 0;
+    for (const auto& layout : layouts) {
+        for (unsigned i = 0; i < layout.model_->GetNumGeometries(); ++i) {
+            Geometry* geometry = layout.model_->GetGeometry(i, 0);
+            VertexBuffer* vertexBuffer = geometry->GetVertexBuffer(0);
+            IndexBuffer* indexBuffer = geometry->GetIndexBuffer();
+
+            unsigned char* vertices = &vertexData[vertexBase * vertexSize];
+            memcpy(vertices, vertexBuffer->GetShadowData() + geometry->GetVertexStart() * vertexSize,
+                geometry->GetVertexCount() * vertexSize);
+
+            for (unsigned j = 0; j < geometry->GetVertexCount(); ++j) {
+                unsigned char* vertex = vertices + j * vertexSize;
+
+                Vector3& position = *((Vector3*)(vertex + positionOffset));
+                position = layout.transform_ * position;
+                box.Merge(position);
+
+                if (normalOffset != M_MAX_UNSIGNED) {
+                    Vector3& normal = *((Vector3*)(vertex + normalOffset));
+                    normal = layout.rotation_ * normal;
+                }
+
+                if (tangentOffset != M_MAX_UNSIGNED) {
+                    Vector4& tangent = *((Vector4*)(vertex + tangentOffset));
+                    tangent = Vector4(layout.rotation_ * Vector3(tangent.x_, tangent.y_, tangent.z_), tangent.w_);
+                }
+            }
+
+            const unsigned char* indices = indexBuffer->GetShadowData() + geometry->GetIndexStart() * indexBuffer->GetIndexSize();
+            for (unsigned j = 0; j < geometry->GetIndexCount(); ++j) {
+                unsigned index = indexBuffer->GetIndexSize() == sizeof(unsigned) ? ((const unsigned*)indices)[j] :
+                    ((const unsigned short*)indices)[j];
+                indexData[indexBase + j] = index - geometry->GetVertexStart() + vertexBase;
+            }
+
+            vertexBase += geometry->GetVertexCount();
+            indexBase += geometry->GetIndexCount();
+        }
+    }
 
-    for (int j = 0; j < 5; ++j) {
-        int rand = Rand() % vertexCount;
-        const Vector3& vertex = *((const Vector3*)(&data[(vertexStart + rand) * vertexSize]));
-        const Vector3&  normal = *((const Vector3*)(&data[(vertexStart + rand) * vertexSize + normalStart]));
+    SharedPtr<VertexBuffer> vertexBuffer(new VertexBuffer(context_));
+    vertexBuffer->SetShadowed(true);
+    vertexBuffer->SetSize(vertexCount, elements);
+    vertexBuffer->SetData(vertexData.Buffer());
+
+    SharedPtr<IndexBuffer> indexBuffer(new IndexBuffer(context_));
+    indexBuffer->SetShadowed(true);
+    bool largeIndices = vertexCount > 65535;
+    indexBuffer->SetSize(indexCount, largeIndices);
+    if (largeIndices) {
+        indexBuffer->SetData(indexData.Buffer());
+    } else {
+        PODVector<unsigned short> shortIndices(indexCount);
+        for (unsigned i = 0; i < indexCount; ++i) {
+            shortIndices[i] = (unsigned short)indexData[i];
+        }
+        indexBuffer->SetData(shortIndices.Buffer());
+    }
 
-        auto* obstacle = RandomObstacle(pipeNode);
-        obstacle->SetPosition(vertex + (2.5f + Random(PIPE_RADIUS)) * normal);
+    SharedPtr<Geometry> geometry(new Geometry(context_));
+    geometry->SetNumVertexBuffers(1);
+    geometry->SetVertexBuffer(0, vertexBuffer);
+    geometry->SetIndexBuffer(indexBuffer);
+    geometry->SetDrawRange(TRIANGLE_LIST, 0, indexCount);
+
+    // Registered by name, so the chunk node survives the snapshot save and instantiate round trip
+    SharedPtr<Model> model(new Model(context_));
+    model->SetName(PIPE_CHUNK_MODEL + String(chunkCount_++));
+    model->SetNumGeometries(1);
+    model->SetNumGeometryLodLevels(0, 1);
+    model->SetGeometry(0, 0, geometry);
+    model->SetBoundingBox(box);
+    GetSubsystem<ResourceCache>()->AddManualResource(model);
+
+    auto* object = chunk->CreateComponent<StaticModel>();
+    object->SetModel(model);
+    object->SetMaterial(pipeMaterial_);
+}
+
+void PipeGenerator::RemovePipes(unsigned count) {
+    auto* cache = GetSubsystem<ResourceCache>();
+
+    // Pipes baked into one chunk share its node, which is removed together with the last of them
+    for (unsigned i = 0; i < count; ++i) {
+        Node* pipe = pipes_[i];
+        if (i + 1 < pipes_.size() && pipes_[i + 1] == pipe) {
+            continue;
+        }
+
+        String modelName = pipe->GetComponent<StaticModel>()->GetModel()->GetName();
+        pipe->Remove();
+        if (modelName.StartsWith(PIPE_CHUNK_MODEL)) {
+            cache->ReleaseResource(Model::GetTypeStatic(), modelName);
+        }
     }
+
+    pipes_.erase(pipes_.begin(), pipes_.begin() + count);
+    segments_.erase(segments_.begin(), segments_.begin() + count);
 }
 
-Node* PipeGenerator::RandomObstacle(Node* parent) {
+Node* PipeGenerator::RandomObstacle(Node* parent, unsigned modelIndex, float unitScale) {
     auto* obstacleNode = parent->CreateChild("obstacle");
     auto* obstacle = obstacleNode->CreateComponent<Obstacle>();
-    auto* model = trashModels_[Rand() % trashModels_.size()];
+    auto* model = trashModels_[modelIndex];
     auto* material = trashMaterials_[Rand() % trashMaterials_.size()];
-    obstacle->Init(model, material);
+    obstacle->Init(model, material, unitScale);
 
     return obstacleNode;
 }
@@ -172,21 +568,150 @@ void PipeGenerator::Init(Scene *scene) {
     scene_ = scene;
     LoadModels();
     Start();
+    CaptureSnapshot();
 }
 
-void PipeGenerator::Reset() {
-    for (auto pipe : pipes_) {
-        pipe->Remove();
+void PipeGenerator::CaptureSnapshot() {
+    // Pipes are saved disabled, so the spare copy stays out of physics and rendering until it is swapped in
+    snapshot_.Clear();
+    snapshotModels_.clear();
+    unsigned nodeCount = 0;
+    for (unsigned i = 0; i < pipes_.size();) {
+        Node* pipe = pipes_[i];
+        unsigned pipeCount = 1;
+        while (i + pipeCount < pipes_.size() && pipes_[i + pipeCount] == pipe) {
+            ++pipeCount;
+        }
+        i += pipeCount;
+        ++nodeCount;
+
+        pipe->SetEnabledRecursive(false);
+        snapshot_.WriteUInt(pipeCount);
+        snapshot_.WriteVector3(pipe->GetPosition());
+        snapshot_.WriteQuaternion(pipe->GetRotation());
+        pipe->Save(snapshot_);
+        pipe->SetEnabledRecursive(true);
+
+        Model* model = pipe->GetComponent<StaticModel>()->GetModel();
+        if (model->GetName().StartsWith(PIPE_CHUNK_MODEL)) {
+            snapshotModels_.push_back(SharedPtr<Model>(model));
+        }
+    }
+
+    snapshotSegments_ = segments_;
+    snapshotNextPos_ = nextPos_;
+    snapshotOffset_ = 0;
+
+    URHO3D_LOGINFOF("Opening snapshot: %u pipes in %u nodes, %u bytes", (unsigned)pipes_.size(), nodeCount, snapshot_.GetSize());
+}
+
+bool PipeGenerator::PrepareSpare() {
+    if (snapshotOffset_ >= snapshot_.GetSize()) {
+        return true;
+    }
+
+    MemoryBuffer source(snapshot_.GetData() + snapshotOffset_, snapshot_.GetSize() - snapshotOffset_);
+    unsigned pipeCount = source.ReadUInt();
+    Vector3 position = source.ReadVector3();
+    Quaternion rotation = source.ReadQuaternion();
+    Node* node = scene_->Instantiate(source, position, rotation);
+    if (!node) {
+        URHO3D_LOGERRORF("Opening snapshot: could not instantiate node at offset %u, restarts generate new pipes", snapshotOffset_);
+        DiscardSnapshot();
+        return true;
+    }
+
+    spare_.insert(spare_.end(), pipeCount, node);
+    snapshotOffset_ += source.GetPosition();
+
+    return snapshotOffset_ >= snapshot_.GetSize();
+}
+
+void PipeGenerator::DiscardSnapshot() {
+    // Pipes of one chunk share a node in the spare list
+    Node* previous = nullptr;
+    for (auto pipe : spare_) {
+        if (pipe != previous) {
+            pipe->Remove();
+        }
+        previous = pipe;
     }
+    spare_.clear();
 
-    pipes_.clear();
+    // Baked models stay registered while pipes in the scene still use them
+    auto* cache = GetSubsystem<ResourceCache>();
+    for (auto& model : snapshotModels_) {
+        String modelName = model->GetName();
+        model.Reset();
+        cache->ReleaseResource(Model::GetTypeStatic(), modelName);
+    }
+    snapshotModels_.clear();
+
+    snapshot_.Clear();
+    snapshotSegments_.clear();
+    snapshotOffset_ = 0;
+}
+
+void PipeGenerator::Reset() {
+    RemovePipes(pipes_.size());
     nextPos_ = Vector3::ZERO;
+    placementStats_ = PlacementStats();
+    ++revision_;
+
+    // Swap in the spare opening, finishing it first if it was not fully prepared in idle frames. Without a snapshot,
+    // or when it failed to load, the opening is generated anew
+    while (snapshot_.GetSize() && !PrepareSpare()) {
+    }
+
+    if (snapshot_.GetSize() == 0) {
+        Start();
+        return;
+    }
+
+    for (auto pipe : spare_) {
+        pipe->SetEnabledRecursive(true);
+    }
+
+    pipes_.swap(spare_);
+    spare_.clear();
+    snapshotOffset_ = 0;
+
+    segments_ = snapshotSegments_;
+    nextPos_ = snapshotNextPos_;
 }
 
 float PipeGenerator::GetEdge() {
     return nextPos_.y_;
 }
 
+unsigned PipeGenerator::GetRevision() const {
+    return revision_;
+}
+
+float PipeGenerator::GetTubeRadius() const {
+    return Config().pipeRadius_ * Config().pipeScale_;
+}
+
+void PipeGenerator::SetBakeChunks(bool enable) {
+    bakeChunks_ = enable;
+}
+
+void PipeGenerator::SetPlacementChecks(bool enable) {
+    placementChecks_ = enable;
+}
+
+const PlacementStats& PipeGenerator::GetPlacementStats() const {
+    return placementStats_;
+}
+
+void PipeGenerator::GetSegments(std::vector<PipeSegment>& result, float top, float bottom) const {
+    for (const auto& segment : segments_) {
+        if (segment.bottom_ <= top && segment.top_ >= bottom) {
+            result.push_back(segment);
+        }
+    }
+}
+
 void PipeGenerator::ScanFiles(std::vector<String> & result, const String& pathName, String ext) {
     StringVector files;
     GetSubsystem<FileSystem>()->ScanDir(files, pathName, ext, SCAN_FILES, false);
@@ -196,3 +721,19 @@ void PipeGenerator::ScanFiles(std::vector<String> & result, const String& pathNa
     }
 }
 
+bool PipeGenerator::GetTubeDistance(const Vector3& position, float& distance) const {
+    for (const auto& segment : segments_) {
+        if (position.y_ > segment.top_ || position.y_ < segment.bottom_) {
+            continue;
+        }
+
+        if (segment.bendTop_ >= segment.bendBottom_ && position.y_ <= segment.bendTop_ && position.y_ >= segment.bendBottom_) {
+            return false;
+        }
+
+        distance = Vector2(position.x_, position.z_).Length();
+        return true;
+    }
+
+    return false;
+}
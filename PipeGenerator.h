@@ -1,20 +1,94 @@
 #pragma once
 
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Matrix3x4.h>
 #include <vector>
 
 namespace Urho3D {
+    class Node;
     class Scene;
-    class Model;
     class Material;
 }
 
 using namespace Urho3D;
 
-const float  PIPE_RADIUS = 10.0f;
+/// World-space vertical extent of a generated pipe segment.
+struct PipeSegment {
+    float top_;
+    float bottom_;
+    /// Span where the tube leaves the straight cylinder around the pipe axis. Empty when bendTop_ < bendBottom_.
+    float bendTop_;
+    float bendBottom_;
+};
+
+/// Model-space span of a pipe model where the tube leaves the straight cylinder of the pipe radius.
+struct PipeProfile {
+    float bendTop_;
+    float bendBottom_;
+    /// Tube cross-section per PIPE_PROFILE_SLICE of height from the model top down: center and smallest wall distance.
+    float top_;
+    std::vector<Vector2> centers_;
+    std::vector<float> radii_;
+
+    /// Return the slice containing model-space height y.
+    unsigned GetSlice(float y) const;
+};
+
+/// Model-space height of one cross-section slice in a pipe profile.
+const float PIPE_PROFILE_SLICE = 1.0f;
+/// Polar grid searched for an opening of probe radius in the tube cross-section.
+const unsigned PLACEMENT_RINGS = 4;
+const unsigned PLACEMENT_SECTORS = 16;
+
+/// Obstacle placement drawn on the main thread, in model space of the pipe.
+struct ObstacleCandidate {
+    float y_;
+    float angle_;
+    /// Distance of the obstacle center from the wall towards the tube center.
+    float depth_;
+    unsigned model_;
+};
+
+/// Accepted and rejected obstacle placements.
+struct PlacementStats {
+    unsigned placed_;
+    /// Candidates rejected because their bounds overlapped an accepted obstacle.
+    unsigned overlaps_;
+    /// Candidates rejected because they closed the last opening of probe radius.
+    unsigned blocked_;
+    /// Candidates rejected because they came within a probe diameter of a pipe end, where the neighbouring pipe's
+    /// obstacles are not checked.
+    unsigned seams_;
+    /// Obstacles not placed because a segment ran out of candidates.
+    unsigned missing_;
+};
+
 const String PIPE_MODEL_DIR = "Models/Pipes/";
 const String TRASH_MODEL_DIR = "Models/Trash/";
 const String TRASH_MATERIAL_DIR = "Materials/Trash/";
+/// Name prefix of baked chunk models, registered as manual resources so chunk nodes can be saved and instantiated.
+const String PIPE_CHUNK_MODEL = "Models/PipeChunk";
+
+/// Light and obstacle placement of one pipe, resolved from model vertices on the work queue.
+struct PipeLayout {
+    /// Parent of lights and obstacles: the pipe node, or the chunk node when pipes are baked.
+    Node* node_;
+    /// Pipe model space to parent space.
+    Matrix3x4 transform_;
+    Quaternion rotation_;
+    float unitScale_;
+    Model* model_;
+    const PipeProfile* profile_;
+    unsigned obstacleCount_;
+    std::vector<ObstacleCandidate> candidates_;
+    std::vector<Vector3> lightPositions_;
+    std::vector<Vector3> lightDirections_;
+    std::vector<Vector3> obstaclePositions_;
+    std::vector<unsigned> obstacleModels_;
+    PlacementStats stats_;
+};
 
 class PipeGenerator: public Object {
 
@@ -27,22 +101,68 @@ public:
 
     PipeGenerator(Context* context);
     void Init(Scene* scene);
+    /// Remove all pipes and restore the opening pipes from the snapshot, or generate new ones when it cannot be loaded.
     void Reset();
+    /// Instantiate one more disabled pipe of the spare opening. Return true when the spare is complete.
+    bool PrepareSpare();
     float GetEdge();
     void GeneratePipes();
+    /// Return the revision counter, incremented whenever pipes are generated or removed.
+    unsigned GetRevision() const;
+    /// Return world-space radius of the straight part of the tube.
+    float GetTubeRadius() const;
+    /// Collect segments overlapping the vertical span [bottom, top].
+    void GetSegments(std::vector<PipeSegment>& result, float top, float bottom) const;
+    /// Return distance from the tube axis. Return false when the position is not in a straight part of the tube.
+    bool GetTubeDistance(const Vector3& position, float& distance) const;
+    /// Enable baking of each generation into one world-space chunk node. Disabled only to measure its effect.
+    void SetBakeChunks(bool enable);
+    /// Enable overlap and opening checks of obstacle placement. Disabled only to measure their effect.
+    void SetPlacementChecks(bool enable);
+    /// Return obstacle placement statistics since the last reset.
+    const PlacementStats& GetPlacementStats() const;
 
 private:
     std::vector<Node*> pipes_;
+    std::vector<PipeSegment> segments_;
+    std::vector<PipeProfile> pipeProfiles_;
     std::vector<Model*> trashModels_;
+    /// Bounding sphere radius of each trash model around its origin, in pipe model space.
+    std::vector<float> trashRadii_;
+    /// Probe bounding sphere radius in pipe model space.
+    float probeRadius_;
+    bool placementChecks_;
+    bool bakeChunks_;
+    unsigned chunkCount_;
+    PlacementStats placementStats_;
     std::vector<Material*> trashMaterials_;
     WeakPtr<Scene> scene_;
     WeakPtr<Material> pipeMaterial_;
     Vector3 nextPos_;
+    unsigned revision_;
+
+    /// Opening pipes saved as binary nodes, each preceded by its position and rotation.
+    VectorBuffer snapshot_;
+    unsigned snapshotOffset_;
+    std::vector<PipeSegment> snapshotSegments_;
+    Vector3 snapshotNextPos_;
+    std::vector<Node*> spare_;
+    /// Baked models referenced by the snapshot, kept loaded while they are not in the scene.
+    std::vector<SharedPtr<Model> > snapshotModels_;
 
     void Start();
+    void CaptureSnapshot();
+    void DiscardSnapshot();
     void LoadModels();
+    PipeProfile ScanProfile(Model* model);
     void ScanFiles(std::vector<String>& result, const String& pathName, String ext = ".mdl");
-    void GenerateLights(Node* pipeNode);
-    void GenerateObstacles(Node* pipeNode);
-    Node* RandomObstacle(Node* parent);
+    void PickObstacles(PipeLayout& layout);
+    void LayoutPipe(PipeLayout& layout) const;
+    void PlaceObstacles(PipeLayout& layout) const;
+    bool HasOpening(const PipeLayout& layout, const Vector3& position, float radius) const;
+    void CreateLights(const PipeLayout& layout);
+    void CreateObstacles(const PipeLayout& layout);
+    void BakeChunk(Node* chunk, const std::vector<PipeLayout>& layouts);
+    void RemovePipes(unsigned count);
+    Node* RandomObstacle(Node* parent, unsigned modelIndex, float unitScale);
 };
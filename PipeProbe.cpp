@@ -1,7 +1,9 @@
 #include <Urho3D/Urho3D.h>
 
 #include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/ProcessUtils.h>
 #include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
 
 #include <Urho3D/Engine/Application.h>
 #include <Urho3D/Engine/Engine.h>
@@ -17,6 +19,9 @@
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/Input/InputEvents.h>
 
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+
 #include <Urho3D/Math/Ray.h>
 
 #include <Urho3D/Scene/Node.h>
@@ -32,12 +37,22 @@
 #include <Urho3D/UI/Text.h>
 #include <Urho3D/UI/UI.h>
 
-#include "CollisionLayers.h"
+#include "Benchmark.h"
+#include "DifficultyController.h"
+#include "GameConfig.h"
 #include "Hud.h"
+#include "JobSystem.h"
+#include "Leaderboard.h"
 #include "PipeProbe.h"
 #include "Probe.h"
 #include "PipeGenerator.h"
 #include "Obstacle.h"
+#include "ObstacleSystem.h"
+#include "PerformanceMonitor.h"
+#include "ProbeCamera.h"
+#include "RenderQuality.h"
+#include "SoundSystem.h"
+#include "Telemetry.h"
 
 #include <Urho3D/Core/Profiler.h>
 #include <Urho3D/DebugNew.h>
@@ -49,32 +64,95 @@
 
 PipeProbe::PipeProbe(Context* context):
     Application(context),
+    runId_(0),
     yaw_(0.0f),
     pitch_(90.0f),
-    drawDebug_(false) {
+    drawDebug_(false),
+    restartPending_(false),
+    benchmark_(false),
+    continuousCollision_(false),
+    threadCount_(0),
+    physicsFps_(0),
+    configFile_("Config/Game.xml") {
 
     SetRandomSeed(Time::GetTimeSinceEpoch());
 
     Hud::RegisterObject(context);
+    PerformanceMonitor::RegisterObject(context);
+    DifficultyController::RegisterObject(context);
     Probe::RegisterObject(context);
     PipeGenerator::RegisterObject(context);
     Obstacle::RegisterObject(context);
+    ObstacleSystem::RegisterObject(context);
+    JobSystem::RegisterObject(context);
+    ProbeCamera::RegisterObject(context);
+    RenderQuality::RegisterObject(context);
+    Telemetry::RegisterObject(context);
+    SoundSystem::RegisterObject(context);
+    Leaderboard::RegisterObject(context);
 }
 
 void PipeProbe::Setup() {
     // Called before engine initialization. engineParameters_ member variable can be modified here
     engineParameters_[EP_FULL_SCREEN] = false;
+
+    const Vector<String>& arguments = GetArguments();
+    for (unsigned i = 0; i < arguments.Size(); ++i) {
+        String argument = arguments[i].ToLower();
+        if (argument == "-threads" && i + 1 < arguments.Size()) {
+            // Worker threads are created in Start() with the requested count instead of one per physical CPU
+            threadCount_ = Clamp(ToUInt(arguments[++i]), 1u, Max(GetNumLogicalCPUs(), 1u));
+            engineParameters_[EP_WORKER_THREADS] = false;
+        } else if (argument == "-config" && i + 1 < arguments.Size()) {
+            configFile_ = arguments[++i];
+        } else if (argument == "-tier" && i + 1 < arguments.Size()) {
+            tier_ = arguments[++i];
+        } else if (argument == "-telemetry" && i + 1 < arguments.Size()) {
+            telemetrySink_ = arguments[++i];
+        } else if (argument == "-ccd") {
+            continuousCollision_ = true;
+        } else if (argument == "-physicsfps" && i + 1 < arguments.Size()) {
+            physicsFps_ = ToInt(arguments[++i]);
+        } else if (argument == "-benchmark") {
+            benchmark_ = true;
+            engineParameters_[EP_HEADLESS] = true;
+        }
+    }
 }
 
 void PipeProbe::Start() {
     // Called after engine initialization. Setup application & subscribe to events here
+    // Difficulty was set up from compiled defaults when registered, the opening pipes must see the loaded values
+    GameConfig::Load(context_, configFile_);
+    GetSubsystem<DifficultyController>()->ResetDensityLimit();
+
+    if (threadCount_) {
+        GetSubsystem<WorkQueue>()->CreateThreads(threadCount_ - 1);
+    }
+
     CreateScene();
+    GetSubsystem<SoundSystem>()->Init(scene_, cameraNode_);
     GetSubsystem<PipeGenerator>()->Init(scene_);
+
+    if (benchmark_) {
+        SharedPtr<Benchmark> benchmark(new Benchmark(context_));
+        benchmark->Run(scene_);
+        engine_->Exit();
+        return;
+    }
     
+    if (!telemetrySink_.Empty()) {
+        GetSubsystem<Telemetry>()->Start(telemetrySink_);
+    }
+
+    String preferencesDir = GetSubsystem<FileSystem>()->GetAppPreferencesDir("PipeProbe", "PipeProbe");
+    GetSubsystem<Leaderboard>()->Open(preferencesDir + LEADERBOARD_FILE);
+
     SubscribeToEvent(E_KEYDOWN, URHO3D_HANDLER(PipeProbe, HandleKeyDown));
     SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(PipeProbe, HandleUpdate));
     SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(PipeProbe, HandlePostUpdate));
     SubscribeToEvent(E_POSTRENDERUPDATE, URHO3D_HANDLER(PipeProbe, HandlePostRenderUpdate));
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(PipeProbe, HandleEndFrame));
     SubscribeToEvent(E_PHYSICSCOLLISIONSTART, URHO3D_HANDLER(PipeProbe, HandleProbeCollision));
 
     // Unsubscribe the SceneUpdate event from base class as the camera node is being controlled in HandlePostUpdate() in this sample
@@ -88,32 +166,89 @@ void PipeProbe::StartGamePlay() {
         return;
     }
 
+    restartTimer_.Reset();
+    restartPending_ = true;
+
     if (probe_ != nullptr) {
         probe_->GetNode()->Remove();
         GetSubsystem<PipeGenerator>()->Reset();
     }
 
+    auto* difficulty = GetSubsystem<DifficultyController>();
+    difficulty->Reset();
+    difficulty->SetActive(true);
+
+    // Only identifies the leaderboard entry. The opening pipes come from the startup snapshot and later density from the
+    // measured frame cost, so no seed could replay a run
+    runId_ = (unsigned)Rand() | (unsigned)Rand() << 15 | (unsigned)Rand() << 30;
+    runTimer_.Reset();
+
     Node* probeNode = scene_->CreateChild("Probe");
     probeNode->SetPosition(Vector3(0.0f, -1.0f, 0.0f));
     probeNode->SetDirection(Vector3::DOWN);
 
     probe_ = probeNode->CreateComponent<Probe>();
-    probe_->Init();
+    probe_->Init(cameraNode_->GetComponent<Camera>());
+    if (continuousCollision_) {
+        probe_->EnableContinuousCollision();
+    }
+
+    cameraNode_->GetComponent<ProbeCamera>()->Reset(probeNode->GetPosition());
+
+    auto* soundSystem = GetSubsystem<SoundSystem>();
+    soundSystem->ResetStats();
+    soundSystem->StartEngine();
 
     pointsTimer_.Reset();
 }
 
 void PipeProbe::StopGamePlay() {
     probe_->SetEnabled(false);
+    GetSubsystem<DifficultyController>()->SetActive(false);
+
+    auto* probeCamera = cameraNode_->GetComponent<ProbeCamera>();
+    URHO3D_LOGINFOF("Camera occlusion: %u queries, %u physics fallbacks", probeCamera->GetQueryCount(), probeCamera->GetFallbackCount());
+
+    auto* monitor = GetSubsystem<PerformanceMonitor>();
+    URHO3D_LOGINFOF("Physics: %d Hz, CCD %s, %.3f ms per step, %.3f ms per frame, %u tunnelings in %u steps", world_->GetFps(),
+        continuousCollision_ ? "on" : "off", monitor->GetPhysicsStepTime(), monitor->GetPhysicsTime(), probe_->GetTunnelingCount(),
+        probe_->GetStepCount());
+
+    const PlacementStats& placement = GetSubsystem<PipeGenerator>()->GetPlacementStats();
+    URHO3D_LOGINFOF("Obstacles: %u placed, %u overlapping, %u path blocking and %u seam candidates rejected, %u missing, "
+        "%.1f broadphase pairs", placement.placed_, placement.overlaps_, placement.blocked_, placement.seams_, placement.missing_,
+        monitor->GetBroadphasePairs());
+
+    auto* soundSystem = GetSubsystem<SoundSystem>();
+    soundSystem->StopEngine();
+    const SoundStats& sound = soundSystem->GetStats();
+    URHO3D_LOGINFOF("Audio: mixer %.2f%% of a core, %.1f us per fragment, %u sounds played, %u stolen, %u culled, %u dropped",
+        soundSystem->GetMixerLoad() * 100.0f, soundSystem->GetMixTime(), sound.played_, sound.stolen_, sound.culled_, sound.dropped_);
 
     auto* hud = GetSubsystem<Hud>();
+    auto* leaderboard = GetSubsystem<Leaderboard>();
+    leaderboard->Append(Max(hud->GetPoints(), 0), runId_, runTimer_.GetMSec(false) / 1000.0f, hud->GetNearMisses());
+
     String information;
-    information.AppendWithFormat("Probe has been crashed!\nScore %d\nPress ENTER to try again.", hud->GetPoints());
+    information.AppendWithFormat("Probe has been crashed!\nScore %d\n", hud->GetPoints());
+
+    std::vector<LeaderboardRecord> top;
+    leaderboard->GetTop(top);
+    if (!top.empty()) {
+        information += "\nBest runs:\n";
+        for (unsigned i = 0; i < top.size(); ++i) {
+            information.AppendWithFormat("%u. %u in %.0f s, %u near misses\n", i + 1, top[i].score_, top[i].duration_, top[i].nearMisses_);
+        }
+    }
+
+    information += "\nPress ENTER to try again.";
     hud->Reset(information);
 }
 
 void PipeProbe::Stop() {
     // Perform optional cleanup after main loop has terminated
+    GetSubsystem<Telemetry>()->Stop();
+    GetSubsystem<Leaderboard>()->Close();
 }
 
 void PipeProbe::HandleProbeCollision(StringHash eventType, VariantMap& eventData) {
@@ -127,6 +262,8 @@ void PipeProbe::HandleProbeCollision(StringHash eventType, VariantMap& eventData
     Node* nodeB = static_cast<Node*>(eventData[P_NODEB].GetPtr());
 
     if (nodeA->GetComponent<Probe>() || nodeB->GetComponent<Probe>()) {
+        GetSubsystem<Telemetry>()->Record(TELEMETRY_CRASH, GetSubsystem<Hud>()->GetPoints());
+        GetSubsystem<SoundSystem>()->PlayCrash(probe_->GetNode()->GetPosition());
         StopGamePlay();
     }
 }
@@ -163,8 +300,15 @@ void PipeProbe::CreateScene() {
     // Create scene subsystem components
     scene_->CreateComponent<Octree>();
     world_ = scene_->CreateComponent<PhysicsWorld>();
+    if (physicsFps_ > 0) {
+        world_->SetFps(physicsFps_);
+    }
     scene_->CreateComponent<DebugRenderer>();
 
+    if (engine_->IsHeadless()) {
+        return;
+    }
+
     XMLFile* style = cache->GetResource<XMLFile>("UI/DefaultStyle.xml");
     GetSubsystem<Hud>()->SetDefaultStyle(style);
                 
@@ -180,8 +324,9 @@ void PipeProbe::CreateScene() {
     cameraNode_->SetDirection(Vector3::DOWN);
     auto* camera = cameraNode_->CreateComponent<Camera>();
     camera->SetFarClip(500.0f);
+    cameraNode_->CreateComponent<ProbeCamera>()->Init(world_);
 
-    GetSubsystem<Renderer>()->SetViewport(0, new Viewport(context_, scene_, camera));
+    GetSubsystem<RenderQuality>()->Init(new Viewport(context_, scene_, camera), RenderQuality::ParseTier(tier_));
 }
 
 void PipeProbe::HandleUpdate(StringHash eventType, VariantMap& eventData) {
@@ -236,27 +381,36 @@ void PipeProbe::HandlePostRenderUpdate(StringHash eventType, VariantMap& eventDa
         scene_->GetComponent<PhysicsWorld>()->DrawDebugGeometry(true);
 }
 
+void PipeProbe::HandleEndFrame(StringHash eventType, VariantMap& eventData) {
+    if (!restartPending_) {
+        // Spare opening pipes are instantiated one per frame while no restart is being measured
+        GetSubsystem<PipeGenerator>()->PrepareSpare();
+        return;
+    }
+
+    restartPending_ = false;
+    float restartTime = restartTimer_.GetUSec(false) / 1000.0f;
+    URHO3D_LOGINFOF("Restart: %.2f ms from ENTER to first playable frame (frame budget %.2f ms)", restartTime, RESTART_FRAME_BUDGET);
+    GetSubsystem<DebugHud>()->SetAppStats("Restart ms", restartTime);
+}
+
 void PipeProbe::HandlePostUpdate(StringHash eventType, VariantMap& eventData) {
+    using namespace PostUpdate;
+
     if (!probe_ || !probe_->IsEnabled())
         return;
 
     Node* probeNode = probe_->GetNode();
-    Quaternion dir = cameraNode_->GetRotation();
-    
-    Vector3 cameraStartPos = probeNode->GetPosition();
-    Vector3 cameraTargetPos = cameraStartPos - dir * Vector3(0.0f, 0.0f, CAMERA_DISTANCE);
-
-    Ray cameraRay(cameraStartPos,  cameraTargetPos - cameraStartPos);
-    PhysicsRaycastResult raycastResult;
-    world_->RaycastSingle(raycastResult, cameraRay, (cameraTargetPos - cameraStartPos).Length(), LAYER_PIPE);
-    if (raycastResult.body_) {
-        cameraTargetPos = cameraStartPos + cameraRay.direction_ * (raycastResult.distance_ - 0.5f);
-    }
 
-    cameraNode_->SetPosition(cameraTargetPos);
+    auto* probeCamera = cameraNode_->GetComponent<ProbeCamera>();
+    probeCamera->Follow(probeNode->GetPosition(), eventData[P_TIMESTEP].GetFloat());
+    auto* debugHud = GetSubsystem<DebugHud>();
+    debugHud->SetAppStats("Camera fallbacks", String(probeCamera->GetFallbackCount()) + " / " + String(probeCamera->GetQueryCount()));
+    debugHud->SetAppStats("Physics step ms", GetSubsystem<PerformanceMonitor>()->GetPhysicsStepTime());
+    debugHud->SetAppStats("Mixer %", GetSubsystem<SoundSystem>()->GetMixerLoad() * 100.0f);
 
     auto * pipeGenerator = GetSubsystem<PipeGenerator>();
-    if (probeNode->GetPosition().y_ - 500 < pipeGenerator->GetEdge()) {
+    if (probeNode->GetPosition().y_ - Config().generationDistance_ < pipeGenerator->GetEdge()) {
         pipeGenerator->GeneratePipes();
     }
 
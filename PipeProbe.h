@@ -11,7 +11,7 @@ using namespace Urho3D;
 
 class Probe;
 
-const float CAMERA_DISTANCE = 45.0f;
+const float RESTART_FRAME_BUDGET = 1000.0f / 60.0f;
 
 class PipeProbe: public Application {
 
@@ -34,6 +34,7 @@ public:
     void HandleKeyDown(StringHash eventType, VariantMap& eventData);
     void HandlePostRenderUpdate(StringHash eventType, VariantMap& eventData);
     void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
 
 private:
     SharedPtr<Scene> scene_;
@@ -42,9 +43,20 @@ private:
     WeakPtr<Probe> probe_;
 
     Timer pointsTimer_;
+    Timer runTimer_;
+    unsigned runId_;
+    HiresTimer restartTimer_;
+    bool restartPending_;
     float yaw_;
     float pitch_;
     bool drawDebug_;
+    bool benchmark_;
+    bool continuousCollision_;
+    unsigned threadCount_;
+    int physicsFps_;
+    String configFile_;
+    String tier_;
+    String telemetrySink_;
 };
 
 URHO3D_DEFINE_APPLICATION_MAIN(PipeProbe)
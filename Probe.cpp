@@ -7,6 +7,8 @@
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Graphics/StaticModel.h>
 
+#include <Urho3D/IO/Log.h>
+
 #include <Urho3D/Math/Ray.h>
 
 #include <Urho3D/Physics/CollisionShape.h>
@@ -21,13 +23,16 @@
 
 #include <iostream>
 
-#include "CollisionLayers.h"
+#include "DifficultyController.h"
+#include "GameConfig.h"
 #include "Hud.h"
+#include "PipeGenerator.h"
 #include "Probe.h"
+#include "SoundSystem.h"
 
-Probe::Probe(Context* context) : LogicComponent(context) {
-    // Only the physics update event is needed: unsubscribe from the rest for optimization
-    SetUpdateEventMask(USE_FIXEDUPDATE);
+Probe::Probe(Context* context) : LogicComponent(context), probeRadius_(0.0f), steps_(0), tunnelings_(0) {
+    // Only the physics update events are needed: unsubscribe from the rest for optimization
+    SetUpdateEventMask(USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE);
 }
 
 void Probe::RegisterObject(Context* context) {
@@ -53,49 +58,88 @@ void Probe::FixedUpdate(float timeStep) {
         force.z_ = 1.0f;
     }
 
-    probeBody_->ApplyForce(force.Normalized() * 3.0f * probeBody_->GetLinearVelocity().Length());
+    probeBody_->ApplyForce(force.Normalized() * Config().steeringFactor_ * probeBody_->GetLinearVelocity().Length());
     node_->SetDirection(direction);
     prevPosition_ = node_->GetPosition();
 
-    if (speedTimer_.GetMSec(false) > 5000) {
-        probeBody_->SetLinearDamping(probeBody_->GetLinearDamping() - 0.01f);
-        speedTimer_.Reset();
+    float linearDamping = GetSubsystem<DifficultyController>()->GetLinearDamping();
+    if (probeBody_->GetLinearDamping() != linearDamping) {
+        probeBody_->SetLinearDamping(linearDamping);
     }
 
+    GetSubsystem<SoundSystem>()->SetEngineSpeed(probeBody_->GetLinearVelocity().Length());
+
     Ray ray(node_->GetPosition(), direction);
     PhysicsRaycastResult result;
-    GetScene()->GetComponent<PhysicsWorld>()->SphereCast(result, ray, 4.0f, 0.1f, LAYER_OBSTACLE);
+    GetScene()->GetComponent<PhysicsWorld>()->SphereCast(result, ray, 4.0f, 0.1f, Config().layerObstacle_);
     if (result.body_) {
-        result.body_->SetCollisionLayer(LAYER_WORLD);
+        result.body_->SetCollisionLayer(Config().layerWorld_);
 
         Vector2 flatPos(camera_->WorldToScreenPoint(result.position_));
         IntVector2 windowSize(GetSubsystem<Graphics>()->GetSize());
         windowSize.x_ *= flatPos.x_;
         windowSize.y_ *= flatPos.y_;
         GetSubsystem<Hud>()->AddExtraPoints(100, windowSize);
+        GetSubsystem<SoundSystem>()->PlayNearMiss(result.position_);
     }
 }
 
-void Probe::Init() {
-    camera_ = GetSubsystem<Renderer>()->GetViewport(0)->GetCamera();
+void Probe::FixedPostUpdate(float timeStep) {
+    ++steps_;
+
+    // Compare positions before and after the step against the straight tube, bends are not covered
+    auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+    float radius = pipeGenerator->GetTubeRadius();
+    float before, after;
+    if (pipeGenerator->GetTubeDistance(prevPosition_, before) && pipeGenerator->GetTubeDistance(node_->GetPosition(), after)
+        && before <= radius && after > radius + probeRadius_) {
+        ++tunnelings_;
+        URHO3D_LOGWARNINGF("Probe tunneled out of the tube at speed %.1f (step %u, CCD %s)", probeBody_->GetLinearVelocity().Length(),
+            steps_, probeBody_->GetCcdRadius() > 0.0f ? "on" : "off");
+    }
+}
+
+void Probe::EnableContinuousCollision() {
+    // The swept sphere must fit inside the probe, so it is sized from the thinnest axis of the model
+    auto* object = node_->GetComponent<StaticModel>();
+    Vector3 halfSize = object->GetModel()->GetBoundingBox().HalfSize() * node_->GetWorldScale();
+    float radius = Min(Min(halfSize.x_, halfSize.y_), halfSize.z_) * Config().ccdRadiusFactor_;
+
+    probeBody_->SetCcdRadius(radius);
+    probeBody_->SetCcdMotionThreshold(radius);
+}
+
+unsigned Probe::GetStepCount() const {
+    return steps_;
+}
+
+unsigned Probe::GetTunnelingCount() const {
+    return tunnelings_;
+}
+
+void Probe::Init(Camera* camera) {
+    camera_ = camera;
     auto* object = node_->CreateComponent<StaticModel>();
 
     auto* cache = GetSubsystem<ResourceCache>();
-    object->SetModel(cache->GetResource<Model>("Models/Probe.mdl"));
+    object->SetModel(cache->GetResource<Model>(PROBE_MODEL));
     object->SetMaterial(cache->GetResource<Material>("Materials/ProbeMaterial.xml"));
     object->SetCastShadows(true);
 
     probeBody_ = node_->CreateComponent<RigidBody>();
     probeBody_->SetMass(4.0f);
-    probeBody_->SetLinearDamping(0.2f);
+    probeBody_->SetLinearDamping(GetSubsystem<DifficultyController>()->GetLinearDamping());
     probeBody_->SetAngularDamping(0.5f);
 
-    probeBody_->SetCollisionLayer(LAYER_WORLD);
+    probeBody_->SetCollisionLayer(Config().layerWorld_);
     probeBody_->SetFriction(400.75f);
     probeBody_->SetLinearVelocity(node_->GetDirection() * 40);
     auto* probeShape = node_->CreateComponent<CollisionShape>();
     probeShape->SetGImpactMesh(object->GetModel());
 
+    Vector3 halfSize = object->GetModel()->GetBoundingBox().HalfSize() * node_->GetWorldScale();
+    probeRadius_ = Max(Max(halfSize.x_, halfSize.y_), halfSize.z_);
+
     // Create probe reflector
     reflectorNode_ = node_->CreateChild("PointLight");
     reflectorNode_->SetDirection(Vector3::FORWARD);
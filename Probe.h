@@ -10,7 +10,7 @@ const unsigned CTRL_BACK = 2;
 const unsigned CTRL_LEFT = 4;
 const unsigned CTRL_RIGHT = 8;
 
-const float ENGINE_POWER = 10.0f;
+const String PROBE_MODEL = "Models/Probe.mdl";
 
 class Probe : public LogicComponent {
 
@@ -24,8 +24,20 @@ public:
     /// Handle physics world update. Called by LogicComponent base class.
     void FixedUpdate(float timeStep) override;
 
+    /// Check the step for tunneling out of the tube. Called by LogicComponent base class.
+    void FixedPostUpdate(float timeStep) override;
+
     /// Initialize the vehicle. Create rendering and physics components. Called by the application.
-    void Init();
+    void Init(Camera* camera);
+
+    /// Enable swept-sphere continuous collision detection sized from the probe model.
+    void EnableContinuousCollision();
+
+    /// Return number of physics steps since Init.
+    unsigned GetStepCount() const;
+
+    /// Return number of steps where the probe left the tube without a collision.
+    unsigned GetTunnelingCount() const;
 
     /// Movement controls.
     Controls controls_;
@@ -36,6 +48,8 @@ private:
     WeakPtr<Node> reflectorNode_;
 
     Vector3 prevPosition_;
-    Timer speedTimer_;
+    float probeRadius_;
+    unsigned steps_;
+    unsigned tunnelings_;
 };
 
@@ -0,0 +1,143 @@
+#include <Urho3D/Core/Context.h>
+
+#include <Urho3D/Math/Ray.h>
+
+#include <Urho3D/Physics/PhysicsWorld.h>
+
+#include <Urho3D/Scene/Node.h>
+
+#include "GameConfig.h"
+#include "ProbeCamera.h"
+
+ProbeCamera::ProbeCamera(Context* context):
+    Component(context),
+    segmentsTop_(-M_INFINITY),
+    segmentsBottom_(M_INFINITY),
+    segmentsRevision_(0),
+    queries_(0),
+    fallbacks_(0) {
+}
+
+void ProbeCamera::RegisterObject(Context* context) {
+    context->RegisterFactory<ProbeCamera>();
+}
+
+void ProbeCamera::Init(PhysicsWorld* world) {
+    world_ = world;
+}
+
+void ProbeCamera::Reset(const Vector3& target) {
+    queries_ = 0;
+    fallbacks_ = 0;
+
+    pivot_.Reset(target);
+    Vector3 desired = target - node_->GetRotation() * Vector3(0.0f, 0.0f, Config().cameraDistance_);
+    distance_.Reset(Occlude(target, desired));
+    node_->SetPosition(target + (desired - target).Normalized() * distance_.GetValue());
+}
+
+void ProbeCamera::Follow(const Vector3& target, float timeStep) {
+    const Vector3& pivot = pivot_.Update(target, Config().cameraPivotSmoothTime_, timeStep);
+    Vector3 desired = pivot - node_->GetRotation() * Vector3(0.0f, 0.0f, Config().cameraDistance_);
+
+    // Pull in immediately when occluded so the camera never enters the wall, ease back out with the spring
+    float clearDistance = Occlude(pivot, desired);
+    if (clearDistance < distance_.GetValue()) {
+        distance_.Reset(clearDistance);
+    } else {
+        distance_.Update(clearDistance, Config().cameraDistanceSmoothTime_, timeStep);
+    }
+
+    node_->SetPosition(pivot + (desired - pivot).Normalized() * distance_.GetValue());
+}
+
+unsigned ProbeCamera::GetQueryCount() const {
+    return queries_;
+}
+
+unsigned ProbeCamera::GetFallbackCount() const {
+    return fallbacks_;
+}
+
+float ProbeCamera::Occlude(const Vector3& start, const Vector3& end) {
+    ++queries_;
+
+    float distance;
+    if (OccludeByTube(start, end, distance)) {
+        return distance;
+    }
+
+    // Bends, chambers and the open space above the first pipe are not covered by the analytic tube
+    ++fallbacks_;
+
+    float length = (end - start).Length();
+    if (!world_) {
+        return length;
+    }
+
+    Ray cameraRay(start, end - start);
+    PhysicsRaycastResult raycastResult;
+    world_->RaycastSingle(raycastResult, cameraRay, length, Config().layerPipe_);
+    if (raycastResult.body_) {
+        return Max(raycastResult.distance_ - Config().cameraWallOffset_, 0.0f);
+    }
+
+    return length;
+}
+
+bool ProbeCamera::OccludeByTube(const Vector3& start, const Vector3& end, float& distance) {
+    float top = Max(start.y_, end.y_);
+    float bottom = Min(start.y_, end.y_);
+    UpdateSegments(top, bottom);
+
+    if (segments_.empty() || top > segments_.front().top_ || bottom < segments_.back().bottom_) {
+        return false;
+    }
+
+    for (const auto& segment : segments_) {
+        if (segment.bendTop_ >= segment.bendBottom_ && segment.bendBottom_ <= top && segment.bendTop_ >= bottom) {
+            return false;
+        }
+    }
+
+    // Pipes are stacked along the world Y axis, so every straight section shares one infinite cylinder
+    float radius = GetSubsystem<PipeGenerator>()->GetTubeRadius();
+    Vector2 origin(start.x_, start.z_);
+    Vector2 delta(end.x_ - start.x_, end.z_ - start.z_);
+
+    float c = origin.LengthSquared() - radius * radius;
+    if (c > 0.0f) {
+        return false;
+    }
+
+    distance = (end - start).Length();
+
+    float a = delta.LengthSquared();
+    if (a < M_EPSILON) {
+        return true;
+    }
+
+    float b = origin.DotProduct(delta);
+    float exit = (-b + sqrtf(b * b - a * c)) / a;
+    if (exit < 1.0f) {
+        distance = Max(distance * exit - Config().cameraWallOffset_, 0.0f);
+    }
+
+    return true;
+}
+
+void ProbeCamera::UpdateSegments(float top, float bottom) {
+    auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+    if (segmentsRevision_ == pipeGenerator->GetRevision() && top <= segmentsTop_ && bottom >= segmentsBottom_) {
+        return;
+    }
+
+    // Cache a window around the requested span so the segment list is rebuilt only every few hundred units
+    float margin = Config().cameraDistance_ * 4.0f;
+    segmentsTop_ = top + margin;
+    segmentsBottom_ = bottom - margin;
+    segmentsRevision_ = pipeGenerator->GetRevision();
+
+    segments_.clear();
+    pipeGenerator->GetSegments(segments_, segmentsTop_, segmentsBottom_);
+}
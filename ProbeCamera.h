@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Urho3D/Scene/Component.h>
+
+#include <vector>
+
+#include "PipeGenerator.h"
+
+namespace Urho3D {
+    class PhysicsWorld;
+}
+
+using namespace Urho3D;
+
+/// Critically damped spring which converges to the target as fast as possible without overshooting.
+template <class T> class CriticallyDampedSpring {
+public:
+    CriticallyDampedSpring(): value_(), velocity_() {
+    }
+
+    void Reset(const T& value) {
+        value_ = value;
+        velocity_ = T();
+    }
+
+    const T& Update(const T& target, float smoothTime, float timeStep) {
+        float omega = 2.0f / Max(smoothTime, M_EPSILON);
+        float x = omega * timeStep;
+        float decay = 1.0f / (1.0f + x + 0.48f * x * x + 0.235f * x * x * x);
+
+        T change = value_ - target;
+        T temp = (velocity_ + change * omega) * timeStep;
+        velocity_ = (velocity_ - temp * omega) * decay;
+        value_ = target + (change + temp) * decay;
+
+        return value_;
+    }
+
+    const T& GetValue() const {
+        return value_;
+    }
+
+private:
+    T value_;
+    T velocity_;
+};
+
+class ProbeCamera: public Component {
+
+    URHO3D_OBJECT(ProbeCamera, Component)
+
+public:
+    explicit ProbeCamera(Context* context);
+
+    static void RegisterObject(Context* context);
+
+    /// Set physics world used by the fallback occlusion test.
+    void Init(PhysicsWorld* world);
+
+    /// Snap the camera behind the target without smoothing.
+    void Reset(const Vector3& target);
+
+    /// Move the camera behind the target along the node's current view direction. Called by the application.
+    void Follow(const Vector3& target, float timeStep);
+
+    /// Return number of occlusion tests performed.
+    unsigned GetQueryCount() const;
+
+    /// Return number of occlusion tests which fell back to the physics world raycast.
+    unsigned GetFallbackCount() const;
+
+private:
+    float Occlude(const Vector3& start, const Vector3& end);
+    bool OccludeByTube(const Vector3& start, const Vector3& end, float& distance);
+    void UpdateSegments(float top, float bottom);
+
+    WeakPtr<PhysicsWorld> world_;
+
+    CriticallyDampedSpring<Vector3> pivot_;
+    CriticallyDampedSpring<float> distance_;
+
+    std::vector<PipeSegment> segments_;
+    float segmentsTop_;
+    float segmentsBottom_;
+    unsigned segmentsRevision_;
+
+    unsigned queries_;
+    unsigned fallbacks_;
+};
@@ -0,0 +1,158 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+
+#include <Urho3D/Engine/Engine.h>
+
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsEvents.h>
+#include <Urho3D/Graphics/RenderSurface.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Graphics/Viewport.h>
+
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#include <Urho3D/UI/Sprite.h>
+#include <Urho3D/UI/UI.h>
+
+#include "GameConfig.h"
+#include "PerformanceMonitor.h"
+#include "RenderQuality.h"
+
+static const TierSettings tierSettings[] = {
+    { "low", "RenderPaths/Forward.xml", false, 512, SHADOWQUALITY_SIMPLE_16BIT },
+    { "medium", "RenderPaths/Prepass.xml", true, 512, SHADOWQUALITY_SIMPLE_16BIT },
+    { "high", "RenderPaths/Deferred.xml", true, 1024, SHADOWQUALITY_PCF_16BIT }
+};
+
+RenderQuality::RenderQuality(Context* context): Object(context), tier_(TIER_HIGH), renderScale_(1.0f) {
+}
+
+RenderQuality::~RenderQuality() {
+    if (screen_) {
+        screen_->Remove();
+    }
+}
+
+void RenderQuality::RegisterObject(Context* context) {
+    context->RegisterSubsystem<RenderQuality>();
+}
+
+PerformanceTier RenderQuality::ParseTier(const String& name) {
+    for (int i = 0; i < MAX_PERFORMANCE_TIERS; ++i) {
+        if (name.Compare(tierSettings[i].name_, false) == 0) {
+            return (PerformanceTier)i;
+        }
+    }
+
+    return TIER_HIGH;
+}
+
+const TierSettings& RenderQuality::GetTierSettings(PerformanceTier tier) {
+    return tierSettings[tier];
+}
+
+void RenderQuality::Init(Viewport* viewport, PerformanceTier tier) {
+    viewport_ = viewport;
+
+    // Frame limiter paces frames when vsync is off or the display refreshes faster than the target
+    GetSubsystem<Engine>()->SetMaxFps((int)Config().targetFps_);
+
+    // Scene is drawn to a texture below render scale 1 and stretched over the screen under the rest of the UI
+    screen_ = new Sprite(context_);
+    screen_->SetVisible(false);
+    GetSubsystem<UI>()->GetRoot()->InsertChild(0, screen_);
+
+    controller_.Reset(1000.0f / Config().targetFps_, tier);
+    tier_ = tier;
+    SetTier(tier);
+    SetRenderScale(1.0f);
+
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(RenderQuality, HandleUpdate));
+    SubscribeToEvent(E_SCREENMODE, URHO3D_HANDLER(RenderQuality, HandleScreenMode));
+}
+
+void RenderQuality::SetTier(PerformanceTier tier) {
+    auto* graphics = GetSubsystem<Graphics>();
+
+    // Fall back to forward rendering where the hardware cannot do the tier's render path
+    const TierSettings& settings = tierSettings[tier];
+    String renderPath = settings.renderPath_;
+    if ((tier == TIER_HIGH && !graphics->GetDeferredSupport()) || (tier == TIER_MEDIUM && !graphics->GetLightPrepassSupport())) {
+        renderPath = tierSettings[TIER_LOW].renderPath_;
+    }
+
+    viewport_->SetRenderPath(GetSubsystem<ResourceCache>()->GetResource<XMLFile>(renderPath));
+
+    auto* renderer = GetSubsystem<Renderer>();
+    renderer->SetDrawShadows(settings.drawShadows_);
+    renderer->SetShadowMapSize(settings.shadowMapSize_);
+    renderer->SetShadowQuality((ShadowQuality)settings.shadowQuality_);
+
+    URHO3D_LOGINFOF("Render quality: tier %s -> %s (%s, shadows %s)", tierSettings[tier_].name_, settings.name_, renderPath.CString(),
+        settings.drawShadows_ ? "on" : "off");
+    tier_ = tier;
+}
+
+void RenderQuality::SetRenderScale(float scale) {
+    auto* graphics = GetSubsystem<Graphics>();
+    auto* renderer = GetSubsystem<Renderer>();
+    renderScale_ = scale;
+
+    if (scale >= 1.0f) {
+        if (renderTexture_) {
+            renderTexture_->GetRenderSurface()->SetViewport(0, nullptr);
+            renderTexture_.Reset();
+        }
+        screen_->SetVisible(false);
+        renderer->SetViewport(0, viewport_);
+        return;
+    }
+
+    int width = Max((int)(graphics->GetWidth() * scale), 1);
+    int height = Max((int)(graphics->GetHeight() * scale), 1);
+    if (!renderTexture_ || renderTexture_->GetWidth() != width || renderTexture_->GetHeight() != height) {
+        renderTexture_ = new Texture2D(context_);
+        renderTexture_->SetSize(width, height, Graphics::GetRGBFormat(), TEXTURE_RENDERTARGET);
+        renderTexture_->SetFilterMode(FILTER_BILINEAR);
+
+        RenderSurface* surface = renderTexture_->GetRenderSurface();
+        surface->SetViewport(0, viewport_);
+        surface->SetUpdateMode(SURFACE_UPDATEALWAYS);
+    }
+
+    renderer->SetViewport(0, nullptr);
+    screen_->SetTexture(renderTexture_);
+    screen_->SetSize(graphics->GetWidth(), graphics->GetHeight());
+    screen_->SetVisible(true);
+}
+
+void RenderQuality::HandleUpdate(StringHash eventType, VariantMap& eventData) {
+    auto* monitor = GetSubsystem<PerformanceMonitor>();
+    if (!controller_.Update(monitor->GetFrameTime(), monitor->GetWorkTime())) {
+        return;
+    }
+
+    if (controller_.GetTier() != tier_) {
+        SetTier(controller_.GetTier());
+    }
+
+    if (controller_.GetRenderScale() != renderScale_) {
+        URHO3D_LOGINFOF("Render quality: scale %.1f -> %.1f (frame %.2f ms, work %.2f ms)", renderScale_, controller_.GetRenderScale(),
+            monitor->GetFrameTime(), monitor->GetWorkTime());
+        SetRenderScale(controller_.GetRenderScale());
+    }
+}
+
+void RenderQuality::HandleScreenMode(StringHash eventType, VariantMap& eventData) {
+    // A mode change may also lose the render target contents, so the texture is created anew even at the same size
+    if (renderTexture_) {
+        renderTexture_->GetRenderSurface()->SetViewport(0, nullptr);
+        renderTexture_.Reset();
+    }
+
+    SetRenderScale(renderScale_);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include "RenderScaleController.h"
+
+namespace Urho3D {
+    class Sprite;
+    class Texture2D;
+    class Viewport;
+}
+
+using namespace Urho3D;
+
+/// Renderer settings of a performance tier.
+struct TierSettings {
+    const char* name_;
+    const char* renderPath_;
+    bool drawShadows_;
+    int shadowMapSize_;
+    int shadowQuality_;
+};
+
+/// Applies performance tiers and adaptive render scale to the game viewport.
+class RenderQuality: public Object {
+
+    URHO3D_OBJECT(RenderQuality, Object)
+
+public:
+    explicit RenderQuality(Context* context);
+    ~RenderQuality();
+    static void RegisterObject(Context* context);
+
+    /// Parse tier name, return TIER_HIGH when unknown.
+    static PerformanceTier ParseTier(const String& name);
+    static const TierSettings& GetTierSettings(PerformanceTier tier);
+
+    /// Take over the viewport and apply the starting tier.
+    void Init(Viewport* viewport, PerformanceTier tier);
+
+    void SetTier(PerformanceTier tier);
+    void SetRenderScale(float scale);
+
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    /// Recreate the render target and screen sprite for the new resolution.
+    void HandleScreenMode(StringHash eventType, VariantMap& eventData);
+
+private:
+    SharedPtr<Viewport> viewport_;
+    SharedPtr<Texture2D> renderTexture_;
+    SharedPtr<Sprite> screen_;
+    RenderScaleController controller_;
+    PerformanceTier tier_;
+    float renderScale_;
+};
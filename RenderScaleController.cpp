@@ -0,0 +1,67 @@
+#include <Urho3D/Math/MathDefs.h>
+
+#include "RenderScaleController.h"
+
+using namespace Urho3D;
+
+RenderScaleController::RenderScaleController() {
+    Reset(1000.0f / 60.0f, TIER_HIGH);
+}
+
+void RenderScaleController::Reset(float targetFrameTime, PerformanceTier tier) {
+    targetFrameTime_ = targetFrameTime;
+    renderScale_ = 1.0f;
+    tier_ = tier;
+    frames_ = 0;
+    headroomDecisions_ = 0;
+}
+
+bool RenderScaleController::Update(float frameTime, float workTime) {
+    if (++frames_ < RENDER_SCALE_INTERVAL) {
+        return false;
+    }
+    frames_ = 0;
+
+    if (frameTime > targetFrameTime_ * 1.1f) {
+        headroomDecisions_ = 0;
+
+        // Lower resolution only helps when the time goes to the GPU, CPU-bound frames need a cheaper tier
+        bool gpuBound = workTime < frameTime * 0.8f;
+        if (gpuBound && renderScale_ > RENDER_SCALE_MIN) {
+            renderScale_ = Max(renderScale_ - RENDER_SCALE_STEP, RENDER_SCALE_MIN);
+            return true;
+        }
+
+        if (tier_ > TIER_LOW) {
+            tier_ = (PerformanceTier)(tier_ - 1);
+            return true;
+        }
+
+        return false;
+    }
+
+    if (workTime < targetFrameTime_ * 0.5f && frameTime < targetFrameTime_ * 1.05f) {
+        if (renderScale_ < 1.0f) {
+            renderScale_ = Min(renderScale_ + RENDER_SCALE_STEP, 1.0f);
+            return true;
+        }
+
+        if (tier_ < TIER_HIGH && ++headroomDecisions_ >= RENDER_TIER_UP_DECISIONS) {
+            headroomDecisions_ = 0;
+            tier_ = (PerformanceTier)(tier_ + 1);
+            return true;
+        }
+    } else {
+        headroomDecisions_ = 0;
+    }
+
+    return false;
+}
+
+float RenderScaleController::GetRenderScale() const {
+    return renderScale_;
+}
+
+PerformanceTier RenderScaleController::GetTier() const {
+    return tier_;
+}
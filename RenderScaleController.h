@@ -0,0 +1,39 @@
+#pragma once
+
+enum PerformanceTier {
+    TIER_LOW = 0,
+    TIER_MEDIUM,
+    TIER_HIGH,
+    MAX_PERFORMANCE_TIERS
+};
+
+const float RENDER_SCALE_MIN = 0.5f;
+const float RENDER_SCALE_STEP = 0.1f;
+/// Frames between decisions, long enough for smoothed timings to settle after a change.
+const unsigned RENDER_SCALE_INTERVAL = 30;
+/// Consecutive decisions with headroom at full scale needed before moving up a tier.
+const unsigned RENDER_TIER_UP_DECISIONS = 20;
+
+/// Chooses render scale and performance tier from frame timings toward a target frame time.
+/// Has no engine dependencies, so it can be driven by synthetic timings in headless runs.
+class RenderScaleController {
+public:
+    RenderScaleController();
+
+    /// Start from the given tier at full render scale.
+    void Reset(float targetFrameTime, PerformanceTier tier);
+
+    /// Feed one frame. Work time is CPU time until render submission, the rest of the frame is treated as GPU and
+    /// presentation. Return true when render scale or tier changed.
+    bool Update(float frameTime, float workTime);
+
+    float GetRenderScale() const;
+    PerformanceTier GetTier() const;
+
+private:
+    float targetFrameTime_;
+    float renderScale_;
+    PerformanceTier tier_;
+    unsigned frames_;
+    unsigned headroomDecisions_;
+};
@@ -0,0 +1,332 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Mutex.h>
+
+#include <Urho3D/Audio/Audio.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundListener.h>
+#include <Urho3D/Audio/SoundSource3D.h>
+#include <Urho3D/Audio/SoundStream.h>
+
+#include <Urho3D/Engine/Engine.h>
+
+#include <Urho3D/IO/Log.h>
+
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include <Urho3D/Scene/Scene.h>
+
+#include <SDL/SDL.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "SoundSystem.h"
+
+static long long SteadyNSec() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Silent endless stream. Its source is mixed first or last of all sources, so the pair times the mixing in between.
+class MixerClock: public SoundStream {
+public:
+    MixerClock(MixerTiming& timing, bool end): timing_(timing), end_(end) {
+        SetFormat(AUDIO_SYNTH_RATE, true, false);
+    }
+
+    unsigned GetData(signed char* dest, unsigned numBytes) override {
+        memset(dest, 0, numBytes);
+
+        long long now = SteadyNSec();
+        if (end_) {
+            // No start after a reset means the fragment began before it, its time would be counted against the new period
+            long long start = timing_.start_.exchange(0);
+            if (start) {
+                timing_.total_ += now - start;
+                ++timing_.fragments_;
+            }
+        } else {
+            timing_.start_ = now;
+        }
+
+        return numBytes;
+    }
+
+private:
+    MixerTiming& timing_;
+    bool end_;
+};
+
+SoundSystem::SoundSystem(Context* context):
+    Object(context),
+    hum_(nullptr),
+    music_(nullptr),
+    engineSpeed_(0.0f),
+    dripTimer_(AUDIO_DRIP_INTERVAL),
+    randomState_(0x9e3779b9),
+    stats_(),
+    statsStart_(SteadyNSec()) {
+
+    timing_.start_ = 0;
+    timing_.total_ = 0;
+    timing_.fragments_ = 0;
+}
+
+void SoundSystem::RegisterObject(Context* context) {
+    context->RegisterSubsystem<SoundSystem>();
+}
+
+void SoundSystem::Init(Scene* scene, Node* listenerNode) {
+    auto* audio = GetSubsystem<Audio>();
+    if (!audio->IsInitialized()) {
+        // Only headless runs, where the engine opens no device by design, mix into the null sink. A missing device in
+        // a windowed game means no sound, not silent mixing at full cost
+        if (!GetSubsystem<Engine>()->IsHeadless()) {
+            URHO3D_LOGWARNING("Audio: no output device, sound disabled");
+            return;
+        }
+
+        // The dummy driver pulls mixed fragments at the device rate
+        if (SDL_AudioInit("dummy") != 0 || !audio->SetMode(AUDIO_BUFFER_LENGTH, AUDIO_MIX_RATE, true, true)) {
+            URHO3D_LOGWARNING("Audio: no output device and no null sink, sound disabled");
+            return;
+        }
+        URHO3D_LOGINFO("Audio: mixing into the null sink");
+    }
+
+    if (!listenerNode) {
+        listenerNode = scene->CreateChild("Listener");
+    }
+    listenerNode_ = listenerNode;
+    audio->SetListener(listenerNode->GetOrCreateComponent<SoundListener>());
+
+    // Timing relies on an engine internal: Audio mixes sources in the order their components were created, so the clock
+    // sources bracket every other source of the game. Should that order change, the mixer load reads low but stays safe
+    Node* audioNode = scene->CreateChild("Audio");
+    auto* startClock = audioNode->CreateComponent<SoundSource>();
+
+    hum_ = audioNode->CreateComponent<SoundSource>();
+    hum_->SetSoundType(SOUND_EFFECT);
+
+    music_ = audioNode->CreateComponent<SoundSource>();
+    music_->SetSoundType(SOUND_MUSIC);
+
+    for (unsigned i = 0; i < AUDIO_VOICES; ++i) {
+        auto* source = audioNode->CreateChild("Voice")->CreateComponent<SoundSource3D>();
+        source->SetDistanceAttenuation(AUDIO_NEAR_DISTANCE, AUDIO_CULL_DISTANCE, 1.0f);
+        voices_.push_back({ source, SOUND_PRIORITY_AMBIENT });
+    }
+
+    auto* endClock = audioNode->CreateComponent<SoundSource>();
+
+    for (auto* clock : { startClock, endClock }) {
+        clock->SetGain(0.0f);
+        clock->Play(new MixerClock(timing_, clock == endClock));
+    }
+
+    const float pi2 = 2.0f * M_PI;
+    humSound_ = Synthesize(1.0f, true, [pi2](float t) {
+        return 0.5f * sinf(pi2 * 55.0f * t) + 0.25f * sinf(pi2 * 110.0f * t) + 0.12f * sinf(pi2 * 165.0f * t);
+    });
+    dripSound_ = Synthesize(0.15f, false, [pi2](float t) {
+        return sinf(pi2 * (1400.0f * t - 1250.0f * t * t)) * expf(-30.0f * t);
+    });
+    nearMissSound_ = Synthesize(0.35f, false, [pi2](float t) {
+        return 0.8f * sinf(pi2 * (500.0f * t + 1500.0f * t * t)) * (1.0f - t / 0.35f);
+    });
+    float noise = 0.0f;
+    crashSound_ = Synthesize(0.9f, false, [this, pi2, &noise](float t) {
+        noise += 0.2f * (NextRandomFloat() * 2.0f - 1.0f - noise);
+        return (0.9f * noise + 0.4f * sinf(pi2 * 40.0f * t)) * expf(-4.0f * t);
+    });
+
+    // Ogg Vorbis sounds stay compressed in memory and are decoded as a stream while mixing
+    auto* cache = GetSubsystem<ResourceCache>();
+    if (cache->Exists(AUDIO_MUSIC)) {
+        auto* music = cache->GetResource<Sound>(AUDIO_MUSIC);
+        music->SetLooped(true);
+        music_->Play(music);
+    } else {
+        URHO3D_LOGINFOF("Audio: no music at %s", AUDIO_MUSIC.CString());
+    }
+
+    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(SoundSystem, HandleUpdate));
+    ResetStats();
+}
+
+Node* SoundSystem::GetListener() const {
+    return listenerNode_;
+}
+
+void SoundSystem::StartEngine() {
+    if (hum_ && !hum_->IsPlaying()) {
+        hum_->Play(humSound_);
+    }
+}
+
+void SoundSystem::StopEngine() {
+    if (hum_) {
+        hum_->Stop();
+    }
+    engineSpeed_ = 0.0f;
+}
+
+void SoundSystem::SetEngineSpeed(float speed) {
+    engineSpeed_ = speed;
+}
+
+void SoundSystem::PlayNearMiss(const Vector3& position) {
+    Play(nearMissSound_, position, SOUND_PRIORITY_EFFECT);
+}
+
+void SoundSystem::PlayCrash(const Vector3& position) {
+    Play(crashSound_, position, SOUND_PRIORITY_CRASH);
+}
+
+bool SoundSystem::Play(Sound* sound, const Vector3& position, SoundPriority priority, float gain) {
+    if (!sound || voices_.empty()) {
+        return false;
+    }
+
+    Vector3 listener = GetListenerPosition();
+    if ((position - listener).LengthSquared() > AUDIO_CULL_DISTANCE * AUDIO_CULL_DISTANCE) {
+        ++stats_.culled_;
+        return false;
+    }
+
+    // Take a free voice, otherwise steal the least important and then farthest one
+    Voice* voice = nullptr;
+    float voiceDistance = 0.0f;
+    for (auto& candidate : voices_) {
+        if (!candidate.source_->IsPlaying()) {
+            voice = &candidate;
+            break;
+        }
+
+        float distance = (candidate.source_->GetNode()->GetPosition() - listener).LengthSquared();
+        if (!voice || candidate.priority_ < voice->priority_ || (candidate.priority_ == voice->priority_ && distance > voiceDistance)) {
+            voice = &candidate;
+            voiceDistance = distance;
+        }
+    }
+
+    if (voice->source_->IsPlaying()) {
+        if (voice->priority_ > priority) {
+            ++stats_.dropped_;
+            return false;
+        }
+        ++stats_.stolen_;
+    }
+
+    voice->priority_ = priority;
+    voice->source_->GetNode()->SetPosition(position);
+    voice->source_->SetSoundType(priority == SOUND_PRIORITY_AMBIENT ? SOUND_AMBIENT : SOUND_EFFECT);
+    voice->source_->SetGain(gain);
+    voice->source_->Play(sound);
+    ++stats_.played_;
+
+    return true;
+}
+
+void SoundSystem::Update(float timeStep) {
+    if (voices_.empty()) {
+        return;
+    }
+
+    if (hum_->IsPlaying()) {
+        float load = Min(engineSpeed_ / AUDIO_HUM_SPEED, 1.0f);
+        hum_->SetFrequency(AUDIO_SYNTH_RATE * (1.0f + load));
+        hum_->SetGain(0.3f + 0.7f * load);
+    }
+
+    Vector3 listener = GetListenerPosition();
+
+    dripTimer_ -= timeStep;
+    if (dripTimer_ <= 0.0f) {
+        dripTimer_ = AUDIO_DRIP_INTERVAL * (0.5f + NextRandomFloat());
+
+        auto* pipeGenerator = GetSubsystem<PipeGenerator>();
+        segments_.clear();
+        pipeGenerator->GetSegments(segments_, listener.y_ + AUDIO_CULL_DISTANCE, listener.y_ - AUDIO_CULL_DISTANCE);
+        if (!segments_.empty()) {
+            const PipeSegment& segment = segments_[NextRandom() % segments_.size()];
+            float angle = NextRandomFloat() * 360.0f;
+            float radius = pipeGenerator->GetTubeRadius();
+            Vector3 position(radius * Cos(angle), Lerp(segment.bottom_, segment.top_, NextRandomFloat()), radius * Sin(angle));
+            Play(dripSound_, position, SOUND_PRIORITY_AMBIENT, AUDIO_DRIP_GAIN);
+        }
+    }
+
+    // The probe falls fast, voices left behind are freed instead of mixing at zero gain
+    for (auto& voice : voices_) {
+        if (voice.source_->IsPlaying() &&
+            (voice.source_->GetNode()->GetPosition() - listener).LengthSquared() > AUDIO_CULL_DISTANCE * AUDIO_CULL_DISTANCE) {
+            voice.source_->Stop();
+            ++stats_.culled_;
+        }
+    }
+}
+
+void SoundSystem::ResetStats() {
+    stats_ = SoundStats();
+
+    // Audio holds its mutex while mixing a fragment, so the reset never lands between the clock sources
+    MutexLock lock(GetSubsystem<Audio>()->GetMutex());
+    timing_.start_ = 0;
+    timing_.total_ = 0;
+    timing_.fragments_ = 0;
+    statsStart_ = SteadyNSec();
+}
+
+const SoundStats& SoundSystem::GetStats() const {
+    return stats_;
+}
+
+float SoundSystem::GetMixerLoad() const {
+    MutexLock lock(GetSubsystem<Audio>()->GetMutex());
+    long long elapsed = SteadyNSec() - statsStart_;
+    return elapsed > 0 ? (float)timing_.total_ / elapsed : 0.0f;
+}
+
+float SoundSystem::GetMixTime() const {
+    MutexLock lock(GetSubsystem<Audio>()->GetMutex());
+    unsigned fragments = timing_.fragments_;
+    return fragments ? timing_.total_ / 1000.0f / fragments : 0.0f;
+}
+
+void SoundSystem::HandleUpdate(StringHash eventType, VariantMap& eventData) {
+    using namespace Update;
+
+    Update(eventData[P_TIMESTEP].GetFloat());
+}
+
+SharedPtr<Sound> SoundSystem::Synthesize(float duration, bool looped, const std::function<float(float)>& wave) {
+    unsigned samples = (unsigned)(duration * AUDIO_SYNTH_RATE);
+    PODVector<short> data(samples);
+    for (unsigned i = 0; i < samples; ++i) {
+        data[i] = (short)(Clamp(wave((float)i / AUDIO_SYNTH_RATE), -1.0f, 1.0f) * 32767.0f);
+    }
+
+    SharedPtr<Sound> sound(new Sound(context_));
+    sound->SetFormat(AUDIO_SYNTH_RATE, true, false);
+    sound->SetData(data.Buffer(), samples * sizeof(short));
+    sound->SetLooped(looped);
+
+    return sound;
+}
+
+Vector3 SoundSystem::GetListenerPosition() const {
+    return listenerNode_ ? listenerNode_->GetWorldPosition() : Vector3::ZERO;
+}
+
+unsigned SoundSystem::NextRandom() {
+    randomState_ ^= randomState_ << 13;
+    randomState_ ^= randomState_ >> 17;
+    randomState_ ^= randomState_ << 5;
+    return randomState_;
+}
+
+float SoundSystem::NextRandomFloat() {
+    return (NextRandom() & 0xffffff) / 16777216.0f;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "PipeGenerator.h"
+
+namespace Urho3D {
+    class Node;
+    class Scene;
+    class Sound;
+    class SoundSource;
+    class SoundSource3D;
+}
+
+using namespace Urho3D;
+
+enum SoundPriority {
+    SOUND_PRIORITY_AMBIENT = 0,
+    SOUND_PRIORITY_EFFECT,
+    SOUND_PRIORITY_CRASH
+};
+
+const unsigned AUDIO_VOICES = 16;
+const unsigned AUDIO_BUFFER_LENGTH = 100;
+const int AUDIO_MIX_RATE = 44100;
+const unsigned AUDIO_SYNTH_RATE = 22050;
+/// Voices farther than this from the listener are not started and are stopped when left behind.
+const float AUDIO_CULL_DISTANCE = 400.0f;
+const float AUDIO_NEAR_DISTANCE = 20.0f;
+/// Probe speed at which the engine hum reaches full gain and twice its base pitch.
+const float AUDIO_HUM_SPEED = 200.0f;
+const float AUDIO_DRIP_INTERVAL = 0.6f;
+const float AUDIO_DRIP_GAIN = 0.4f;
+const String AUDIO_MUSIC = "Music/PipeProbe.ogg";
+
+struct SoundStats {
+    unsigned played_;
+    /// Playing voices of lower or equal priority taken over by a new sound.
+    unsigned stolen_;
+    /// Sounds not started or stopped because they were out of hearing distance.
+    unsigned culled_;
+    /// Sounds not started because every voice played something more important.
+    unsigned dropped_;
+};
+
+/// Timestamps of the mixer clock streams, written on the audio thread. Reset and read together under the Audio mutex.
+struct MixerTiming {
+    std::atomic<long long> start_;
+    std::atomic<long long> total_;
+    std::atomic<unsigned> fragments_;
+};
+
+/// Game sounds on a fixed pool of positional voices. Effects are synthesized at startup, music is an Ogg Vorbis file
+/// decoded while mixing. Urho3D mixes on the audio device thread; in headless runs the SDL dummy driver stands in as a null sink.
+class SoundSystem: public Object {
+
+    URHO3D_OBJECT(SoundSystem, Object)
+
+public:
+    explicit SoundSystem(Context* context);
+    static void RegisterObject(Context* context);
+
+    /// Create voices, effects and music in the scene. A listener node is created when none is given.
+    void Init(Scene* scene, Node* listenerNode);
+    Node* GetListener() const;
+
+    void StartEngine();
+    void StopEngine();
+    /// Set probe speed driving the engine hum pitch and gain. Called from physics steps.
+    void SetEngineSpeed(float speed);
+
+    void PlayNearMiss(const Vector3& position);
+    void PlayCrash(const Vector3& position);
+    /// Play a sound on a pooled voice. Return false when culled by distance or when no voice could be stolen.
+    bool Play(Sound* sound, const Vector3& position, SoundPriority priority, float gain = 1.0f);
+
+    /// Update engine hum, ambient drips and distance culling. Called on E_UPDATE.
+    void Update(float timeStep);
+
+    void ResetStats();
+    const SoundStats& GetStats() const;
+    /// Return the share of wall time the audio thread spent mixing sources since the last reset.
+    float GetMixerLoad() const;
+    /// Return average time in microseconds spent mixing one output fragment since the last reset.
+    float GetMixTime() const;
+
+    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+
+private:
+    struct Voice {
+        SoundSource3D* source_;
+        SoundPriority priority_;
+    };
+
+    SharedPtr<Sound> Synthesize(float duration, bool looped, const std::function<float(float)>& wave);
+    Vector3 GetListenerPosition() const;
+    unsigned NextRandom();
+    float NextRandomFloat();
+
+    WeakPtr<Node> listenerNode_;
+    std::vector<Voice> voices_;
+    SoundSource* hum_;
+    SoundSource* music_;
+
+    SharedPtr<Sound> humSound_;
+    SharedPtr<Sound> dripSound_;
+    SharedPtr<Sound> nearMissSound_;
+    SharedPtr<Sound> crashSound_;
+
+    float engineSpeed_;
+    float dripTimer_;
+    /// Ambient randomness has its own generator, so it does not shift the gameplay random sequence.
+    unsigned randomState_;
+    std::vector<PipeSegment> segments_;
+
+    SoundStats stats_;
+    MixerTiming timing_;
+    long long statsStart_;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+/// Lock-free ring buffer for exactly one producer thread and one consumer thread. Capacity must be a power of two.
+template <class T, unsigned Capacity> class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing(): head_(0), tail_(0) {
+    }
+
+    /// Append an item. Return false without blocking when the ring is full. Producer thread only.
+    bool Push(const T& item) {
+        unsigned head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        items_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Remove the oldest item. Return false when the ring is empty. Consumer thread only.
+    bool Pop(T& item) {
+        unsigned tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = items_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Indices on separate cache lines so producer and consumer do not invalidate each other
+    alignas(64) std::atomic<unsigned> head_;
+    alignas(64) std::atomic<unsigned> tail_;
+    T items_[Capacity];
+};
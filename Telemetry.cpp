@@ -0,0 +1,245 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <Urho3D/IO/Log.h>
+
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Telemetry.h"
+
+static const char* metricNames[] = {
+    "score",
+    "near_miss",
+    "crash",
+    "segments",
+    "frame_ms"
+};
+
+static long long NowUSec() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static long long SteadyNSec() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Telemetry::Telemetry(Context* context):
+    Object(context),
+    enabled_(false),
+    file_(nullptr),
+    socket_(-1),
+    fileSize_(0),
+    records_(0),
+    dropped_(0),
+    recordTime_(0),
+    reportStart_(0),
+    overhead_(0.0f) {
+}
+
+Telemetry::~Telemetry() {
+    Stop();
+}
+
+void Telemetry::RegisterObject(Context* context) {
+    context->RegisterSubsystem<Telemetry>();
+}
+
+bool Telemetry::Start(const String& sink) {
+    Stop();
+
+    sink_ = sink;
+    if (!Open()) {
+        URHO3D_LOGERRORF("Telemetry: could not open sink %s", sink.CString());
+        return false;
+    }
+
+    enabled_ = true;
+    records_ = 0;
+    dropped_ = 0;
+    recordTime_ = 0;
+    reportStart_ = SteadyNSec();
+
+    Run();
+    SubscribeToEvent(E_ENDFRAME, URHO3D_HANDLER(Telemetry, HandleEndFrame));
+    URHO3D_LOGINFOF("Telemetry: streaming to %s", sink.CString());
+    return true;
+}
+
+void Telemetry::Stop() {
+    if (!enabled_) {
+        return;
+    }
+
+    enabled_ = false;
+    UnsubscribeFromEvent(E_ENDFRAME);
+
+    // The writer drains what is left before it exits
+    Thread::Stop();
+    Close();
+}
+
+void Telemetry::Record(TelemetryMetric metric, float value) {
+    if (!enabled_) {
+        return;
+    }
+
+    long long start = SteadyNSec();
+
+    TelemetryRecord record;
+    record.timestamp_ = NowUSec();
+    record.metric_ = metric;
+    record.value_ = value;
+    if (!ring_.Push(record)) {
+        ++dropped_;
+    }
+    ++records_;
+
+    recordTime_ += SteadyNSec() - start;
+}
+
+float Telemetry::GetOverhead() const {
+    return overhead_;
+}
+
+unsigned Telemetry::GetDroppedCount() const {
+    return dropped_;
+}
+
+void Telemetry::ThreadFunction() {
+    char line[128];
+    TelemetryRecord record;
+
+    while (true) {
+        // Read the flag before draining, so records pushed before Stop() are written on the last pass
+        bool running = shouldRun_;
+        while (ring_.Pop(record)) {
+            int size = snprintf(line, sizeof(line), "pipeprobe.%s %g %llu\n", metricNames[record.metric_], record.value_,
+                record.timestamp_);
+            Write(line, (unsigned)size);
+        }
+
+        if (file_) {
+            fflush(file_);
+        }
+
+        if (!running) {
+            break;
+        }
+
+        Time::Sleep(TELEMETRY_DRAIN_INTERVAL);
+    }
+}
+
+void Telemetry::HandleEndFrame(StringHash eventType, VariantMap& eventData) {
+    Record(TELEMETRY_FRAME_TIME, GetSubsystem<Time>()->GetTimeStep() * 1000.0f);
+
+    long long elapsed = SteadyNSec() - reportStart_;
+    if (elapsed < TELEMETRY_REPORT_INTERVAL * 1000000LL) {
+        return;
+    }
+
+    overhead_ = (float)recordTime_ / elapsed;
+    URHO3D_LOGINFOF("Telemetry: %u records, %u dropped, %.4f%% of frame time spent recording", records_, dropped_, overhead_ * 100.0f);
+    if (overhead_ > 0.01f) {
+        URHO3D_LOGWARNING("Telemetry: recording overhead is above 1% of frame time");
+    }
+
+    records_ = 0;
+    dropped_ = 0;
+    recordTime_ = 0;
+    reportStart_ = SteadyNSec();
+}
+
+bool Telemetry::Open() {
+    fileSize_ = 0;
+
+    if (sink_ == "null") {
+        return true;
+    }
+
+    if (sink_.StartsWith("file:")) {
+        file_ = fopen(sink_.Substring(5).CString(), "ab");
+        if (file_) {
+            fseek(file_, 0, SEEK_END);
+            fileSize_ = (unsigned)ftell(file_);
+        }
+        return file_ != nullptr;
+    }
+
+#ifndef _WIN32
+    if (sink_.StartsWith("unix:")) {
+        String path = sink_.Substring(5);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.Length() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        strcpy(address.sun_path, path.CString());
+
+        socket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (socket_ < 0 || connect(socket_, (sockaddr*)&address, sizeof(address)) < 0) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+void Telemetry::Close() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+#ifndef _WIN32
+    if (socket_ >= 0) {
+        close(socket_);
+        socket_ = -1;
+    }
+#endif
+}
+
+void Telemetry::Write(const char* data, unsigned size) {
+    if (file_) {
+        if (fileSize_ + size > TELEMETRY_FILE_LIMIT) {
+            // Keep one previous file, the reader is expected to follow the current one
+            String path = sink_.Substring(5);
+            fclose(file_);
+            rename(path.CString(), (path + ".1").CString());
+            file_ = fopen(path.CString(), "wb");
+            fileSize_ = 0;
+            if (!file_) {
+                return;
+            }
+        }
+
+        fwrite(data, 1, size, file_);
+        fileSize_ += size;
+    }
+
+#ifndef _WIN32
+    if (socket_ >= 0) {
+#ifdef MSG_NOSIGNAL
+        int flags = MSG_NOSIGNAL;
+#else
+        int flags = 0;
+#endif
+        // A disconnected reader only loses samples, the game keeps running
+        if (send(socket_, data, size, flags) < 0) {
+            close(socket_);
+            socket_ = -1;
+        }
+    }
+#endif
+}
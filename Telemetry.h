@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Thread.h>
+
+#include <atomic>
+#include <cstdio>
+
+#include "SpscRing.h"
+
+using namespace Urho3D;
+
+enum TelemetryMetric {
+    TELEMETRY_SCORE = 0,
+    TELEMETRY_NEAR_MISS,
+    TELEMETRY_CRASH,
+    TELEMETRY_SEGMENTS,
+    TELEMETRY_FRAME_TIME,
+    MAX_TELEMETRY_METRICS
+};
+
+const unsigned TELEMETRY_RING_SIZE = 4096;
+const unsigned TELEMETRY_DRAIN_INTERVAL = 10;
+const unsigned TELEMETRY_FILE_LIMIT = 8 * 1024 * 1024;
+const unsigned TELEMETRY_REPORT_INTERVAL = 10000;
+
+struct TelemetryRecord {
+    unsigned long long timestamp_;
+    unsigned metric_;
+    float value_;
+};
+
+/// Streams gameplay metrics off the main thread. The main thread writes into a lock-free ring and never blocks,
+/// a background thread drains it in line protocol, one "pipeprobe.<metric> <value> <microseconds since epoch>" per line.
+class Telemetry: public Object, public Thread {
+
+    URHO3D_OBJECT(Telemetry, Object)
+
+public:
+    explicit Telemetry(Context* context);
+    ~Telemetry();
+    static void RegisterObject(Context* context);
+
+    /// Start streaming to "file:<path>", rotated at TELEMETRY_FILE_LIMIT, "unix:<socket path>" or "null" which only drains.
+    bool Start(const String& sink);
+    void Stop();
+
+    /// Queue a sample. Dropped when the ring is full. Main thread only.
+    void Record(TelemetryMetric metric, float value);
+
+    /// Return main thread time spent in Record as a share of elapsed frame time since the last report.
+    float GetOverhead() const;
+    unsigned GetDroppedCount() const;
+
+    void ThreadFunction() override;
+
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+
+private:
+    bool Open();
+    void Close();
+    void Write(const char* data, unsigned size);
+
+    SpscRing<TelemetryRecord, TELEMETRY_RING_SIZE> ring_;
+    bool enabled_;
+    String sink_;
+
+    // Writer thread state
+    FILE* file_;
+    int socket_;
+    unsigned fileSize_;
+
+    // Main thread statistics
+    unsigned records_;
+    unsigned dropped_;
+    long long recordTime_;
+    long long reportStart_;
+    float overhead_;
+};